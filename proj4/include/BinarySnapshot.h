@@ -0,0 +1,113 @@
+#ifndef BINARYSNAPSHOT_H
+#define BINARYSNAPSHOT_H
+
+#include "DataSource.h"
+#include "DataSink.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Builds a snapshot in memory and writes it out in one go as
+// header (8 byte magic, version, padding, payload size, checksum of the payload) followed by the payload.
+// Values are stored as their raw bytes, so a snapshot only loads on a machine with the same byte order.
+// The header is 32 bytes and the elements of every array start on an 8 byte boundary, so when the file is mapped
+// into memory (page aligned) CSnapshotReader::ReadArray can hand out pointers straight into it.
+class CSnapshotWriter{
+    private:
+        std::vector<char> DPayload;
+
+        void Align();
+    public:
+        static constexpr std::size_t HeaderSize = 32;
+        static constexpr std::size_t ArrayAlignment = 8;
+
+        template <typename T> void Write(const T &value){
+            static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written as bytes");
+            const char *Bytes = reinterpret_cast<const char *>(&value);
+            DPayload.insert(DPayload.end(), Bytes, Bytes + sizeof(T));
+        }
+
+        template <typename T> void WriteArray(const T *values, std::size_t count){
+            static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written as bytes");
+            static_assert(alignof(T) <= ArrayAlignment, "array elements cant need more than ArrayAlignment");
+            Write<uint64_t>(count);
+            Align();
+            const char *Bytes = reinterpret_cast<const char *>(values);
+            DPayload.insert(DPayload.end(), Bytes, Bytes + count * sizeof(T));
+        }
+
+        template <typename T> void WriteVector(const std::vector<T> &values){
+            WriteArray(values.data(), values.size());
+        }
+
+        void WriteString(const std::string &str);
+
+        bool Finish(std::shared_ptr<CDataSink> sink, const char magic[8], uint32_t version) const;
+};
+
+// Reads a snapshot written by CSnapshotWriter, Start checks the header and the checksum before anything is read.
+// It either reads the payload from a data source into its own buffer or reads it in place from memory the caller
+// keeps alive (a mapped file). Every read returns false instead of running past the end, so a short or damaged
+// payload is just a failed load.
+class CSnapshotReader{
+    private:
+        std::vector<char> DPayload;
+        const char *DData = nullptr;
+        std::size_t DSize = 0;
+        std::size_t DOffset = 0;
+
+        bool CheckHeader(const char *header, const char magic[8], uint32_t version, uint64_t &size, uint64_t &sum) const;
+        bool Align() noexcept;
+    public:
+        bool Start(std::shared_ptr<CDataSource> source, const char magic[8], uint32_t version);
+        //data has to start on an 8 byte boundary for ReadArray to give aligned pointers
+        bool Start(const char *data, std::size_t size, const char magic[8], uint32_t version);
+
+        template <typename T> bool Read(T &value){
+            static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read as bytes");
+            if(DSize - DOffset < sizeof(T)){
+                return false;
+            }
+            std::memcpy(&value, DData + DOffset, sizeof(T));
+            DOffset += sizeof(T);
+            return true;
+        }
+
+        //points values at the array in the payload without copying, it stays valid as long as the payload does
+        template <typename T> bool ReadArray(const T *&values, std::size_t &count){
+            static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read as bytes");
+            uint64_t Count;
+            if(!Read(Count) || !Align() || Count > (DSize - DOffset) / sizeof(T)){
+                return false;
+            }
+            values = reinterpret_cast<const T *>(DData + DOffset);
+            count = Count;
+            DOffset += Count * sizeof(T);
+            return true;
+        }
+
+        template <typename T> bool ReadVector(std::vector<T> &values){
+            const T *Values;
+            std::size_t Count;
+            if(!ReadArray(Values, Count)){
+                return false;
+            }
+            values.assign(Values, Values + Count);
+            return true;
+        }
+
+        bool ReadString(std::string &str);
+
+        //where the next read starts, counted from the start of the payload
+        std::size_t Offset() const noexcept;
+
+        //true once everything in the payload has been read
+        bool Done() const noexcept;
+
+        static uint64_t Checksum(const char *data, std::size_t size) noexcept;
+};
+
+#endif
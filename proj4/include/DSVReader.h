@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "DataSource.h"
 
 class CDSVReader{
@@ -16,6 +18,9 @@ class CDSVReader{
 
         bool End() const;
         bool ReadRow(std::vector<std::string> &row);
+        //same as ReadRow but without making a string per field, the views point into the reader (or straight into
+        //the source's memory) and are only valid until the next read
+        bool ReadRowView(std::vector<std::string_view> &row);
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define DATASOURCE_H
 
 #include <vector>
+#include <string_view>
 
 class CDataSource{
     public:
@@ -10,6 +11,12 @@ class CDataSource{
         virtual bool Get(char &ch) noexcept = 0;
         virtual bool Peek(char &ch) noexcept = 0;
         virtual bool Read(std::vector<char> &buf, std::size_t count) noexcept = 0;
+        //optional zero copy version of Read, points chunk at up to max of the next bytes where the source already
+        //has them in memory and moves past them. chunk is only valid until the next call on the source. returns
+        //false at the end, or always if the source cant lend its bytes (the default), callers then fall back to Read
+        virtual bool Borrow(std::string_view &chunk, std::size_t max) noexcept{
+            return false;
+        }
 };
 
 #endif
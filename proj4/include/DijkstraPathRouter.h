@@ -2,22 +2,74 @@
 #define DIJKSTRAPATHROUTER_H
 
 #include "PathRouter.h"
+#include "DataSource.h"
+#include "DataSink.h"
 #include <memory>
+#include <functional>
+#include <utility>
+#include <limits>
+
+class CMemoryMappedFile;
 
 class CDijkstraPathRouter : public CPathRouter{
+    public:
+        enum class ESearchMode {Dijkstra, Bidirectional, AStar, Landmarks, ContractionHierarchies};
+        enum class EQueuePolicy {BinaryHeap, QuaternaryHeap, RadixHeap};
+        using TLocation = std::pair<double, double>;
+        using THeuristic = std::function<double(const TLocation &, const TLocation &)>;
+        //the vertices a query can start (or end) at and the distance already covered to get there, for a point
+        //part way along an edge, like the middle of a chain the planner contracted into one edge
+        using TSeeds = std::vector<std::pair<TVertexID, double>>;
+
+        //scratch space a query searches in, kept between queries so it doesnt have to be allocated and
+        //cleared for every one. one per thread, it can be used with any router
+        class CQueryContext{
+            private:
+                friend class CDijkstraPathRouter;
+                struct SImplementation;
+                std::unique_ptr<SImplementation> DImplementation;
+            public:
+                CQueryContext();
+                ~CQueryContext();
+        };
     private:
         struct SImplementation;
         std::unique_ptr<SImplementation> DImplementation;
     public:
-        CDijkstraPathRouter();
+        CDijkstraPathRouter(ESearchMode mode = ESearchMode::Dijkstra);
+        //makes the router from a snapshot Save wrote that is mapped into memory, reading the graph arrays in place
+        //instead of copying them. the snapshot is the size bytes at offset in the file (the rest of it by default).
+        //throws std::invalid_argument if the snapshot is bad
+        CDijkstraPathRouter(std::shared_ptr<const CMemoryMappedFile> snapshot, std::size_t offset = 0, std::size_t size = std::numeric_limits<std::size_t>::max());
         ~CDijkstraPathRouter();
 
+        ESearchMode SearchMode() const noexcept;
+        void SetQueuePolicy(EQueuePolicy policy) noexcept;
+        EQueuePolicy QueuePolicy() const noexcept;
+        bool SetHeuristic(const std::vector<TLocation> &locations, THeuristic heuristic) noexcept;
+        void SetLandmarkCount(std::size_t count) noexcept;
+        std::size_t LandmarkCount() const noexcept;
+        std::size_t BytesPerLandmark() const noexcept;
+
         std::size_t VertexCount() const noexcept;
         TVertexID AddVertex(std::any tag) noexcept;
         std::any GetVertexTag(TVertexID id) const noexcept;
         bool AddEdge(TVertexID src, TVertexID dest, double weight, bool bidir = false) noexcept;
         bool Precompute(std::chrono::steady_clock::time_point deadline) noexcept;
+        //writes the built graph (CSR, hierarchy, landmarks) as a binary snapshot, Load replaces the whole graph with one
+        //Load returns false and leaves the router alone if the snapshot is damaged or from another version
+        bool Save(std::shared_ptr<CDataSink> sink) const noexcept;
+        bool Load(std::shared_ptr<CDataSource> source) noexcept;
         double FindShortestPath(TVertexID src, TVertexID dest, std::vector<TVertexID> &path) noexcept;
+        //safe to call from many threads at once, each with its own context, as long as nothing adds to the graph meanwhile
+        double FindShortestPath(TVertexID src, TVertexID dest, std::vector<TVertexID> &path, CQueryContext &context) const noexcept;
+        //shortest path from any of sources to any of targets counting the seed distances at both ends, path runs
+        //from the source vertex it left from to the target vertex it got to
+        double FindShortestPath(const TSeeds &sources, const TSeeds &targets, std::vector<TVertexID> &path, CQueryContext &context) const noexcept;
+        //distances[i] is the distance from src to targets[i], NoPathExists if there is no path. false if it ran out of memory
+        bool FindDistances(TVertexID src, const std::vector<TVertexID> &targets, std::vector<double> &distances, CQueryContext &context) const noexcept;
+        //matrix[i][j] is the distance from sources[i] to targets[j]
+        bool FindDistanceMatrix(const std::vector<TVertexID> &sources, const std::vector<TVertexID> &targets, std::vector<std::vector<double>> &matrix, CQueryContext &context) const noexcept;
 };
 
 #endif
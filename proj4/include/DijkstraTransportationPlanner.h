@@ -2,6 +2,10 @@
 #define DIJKSTRATRANSPORTATIONPLANNER_H
 
 #include "TransportationPlanner.h"
+#include "DataSource.h"
+#include "DataSink.h"
+
+class CMemoryMappedFile;
 
 class CDijkstraTransportationPlanner : public CTransportationPlanner{
     private:
@@ -9,13 +13,32 @@ class CDijkstraTransportationPlanner : public CTransportationPlanner{
         std::unique_ptr<SImplementation> DImplementation;
     public:
         CDijkstraTransportationPlanner(std::shared_ptr<SConfiguration> config);
+        //restores a planner Save wrote instead of building it, config only has to give the same speeds and stop time
+        //(the street map and bus system can be null). throws std::invalid_argument if the snapshot is bad or doesnt match
+        CDijkstraTransportationPlanner(std::shared_ptr<SConfiguration> config, std::shared_ptr<CDataSource> snapshot);
+        //same but reads the snapshot in place from a mapped file, the routers keep the mapping alive and search
+        //the graph arrays in it directly instead of copying them
+        CDijkstraTransportationPlanner(std::shared_ptr<SConfiguration> config, std::shared_ptr<const CMemoryMappedFile> snapshot);
         ~CDijkstraTransportationPlanner();
 
+        //writes the built planner as a versioned binary snapshot with a checksum, false if it couldnt
+        bool Save(std::shared_ptr<CDataSink> sink) const;
+
         std::size_t NodeCount() const noexcept override;
         std::shared_ptr<CStreetMap::SNode> SortedNodeByIndex(std::size_t index) const noexcept override;
 
-        double FindShortestPath(TNodeID src, TNodeID dest, std::vector< TNodeID > &path) override;
-        double FindFastestPath(TNodeID src, TNodeID dest, std::vector< TTripStep > &path) override;
+        //the planner does not change after it is constructed, so these are safe to call from many threads at once
+        double FindShortestPath(TNodeID src, TNodeID dest, std::vector< TNodeID > &path) const override;
+        double FindFastestPath(TNodeID src, TNodeID dest, std::vector< TTripStep > &path) const override;
+        void FindShortestPaths(const std::vector< std::pair< TNodeID, TNodeID > > &pairs, std::vector< double > &distances, std::vector< std::vector< TNodeID > > &paths, std::size_t threadcount = 0) const override;
+        void FindFastestPaths(const std::vector< std::pair< TNodeID, TNodeID > > &pairs, std::vector< double > &times, std::vector< std::vector< TTripStep > > &paths, std::size_t threadcount = 0) const override;
+        //distance/time tables, one to many and many to many, NoPathExists where there is no path (or an unknown id)
+        //thread safe like the queries above. the router only says whether it could build its table, not why not,
+        //so any failure in there (in practice running out of memory) is thrown as std::bad_alloc
+        std::vector< double > FindShortestDistances(TNodeID src, const std::vector< TNodeID > &dests) const;
+        std::vector< std::vector< double > > FindShortestDistanceMatrix(const std::vector< TNodeID > &srcs, const std::vector< TNodeID > &dests) const;
+        std::vector< double > FindFastestTimes(TNodeID src, const std::vector< TNodeID > &dests) const;
+        std::vector< std::vector< double > > FindFastestTimeMatrix(const std::vector< TNodeID > &srcs, const std::vector< TNodeID > &dests) const;
         bool GetPathDescription(const std::vector< TTripStep > &path, std::vector< std::string > &desc) const override;
 };
 
@@ -2,14 +2,21 @@
 #define FILEDATAFACTORY_H
 
 #include "DataFactory.h"
+#include <limits>
 
 class CFileDataFactory : public CDataFactory{
     private:
         std::string DBasePath;
+        std::size_t DMapThreshold;
 
     public:
-        CFileDataFactory(const std::string &path);
-;
+        //sources for files at least this big are memory mapped (CMMapDataSource), smaller ones are read as streams
+        static constexpr std::size_t DefaultMapThreshold = 256 * 1024;
+        static constexpr std::size_t AlwaysMap = 0;
+        static constexpr std::size_t NeverMap = std::numeric_limits<std::size_t>::max();
+
+        CFileDataFactory(const std::string &path, std::size_t mapthreshold = DefaultMapThreshold);
+
         std::shared_ptr< CDataSource > CreateSource(const std::string &name) noexcept override;
         std::shared_ptr< CDataSink > CreateSink(const std::string &name) noexcept override;
 };
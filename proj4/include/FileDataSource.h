@@ -4,9 +4,19 @@
 #include "DataSource.h"
 #include <fstream>
 
+// Reads the file in large blocks, Get and Peek are served out of the block so they dont touch the stream.
+// The block is refilled as soon as it runs out, so it is only ever empty once the whole file has been read.
+// Borrow lends out the rest of the current block and swaps in a second one to refill, so the lent bytes stay put
+// until the next call.
 class CFileDataSource : public CDataSource{
     private:
+        static constexpr std::size_t BlockSize = 64 * 1024;
         std::ifstream DFile;
+        std::vector<char> DBlock;
+        std::vector<char> DLentBlock;
+        std::size_t DOffset;
+
+        void FillBlock();
     public:
         CFileDataSource(const std::string &filename);
 
@@ -14,6 +24,7 @@ class CFileDataSource : public CDataSource{
         bool Get(char &ch) noexcept override;
         bool Peek(char &ch) noexcept override;
         bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool Borrow(std::string_view &chunk, std::size_t max) noexcept override;
 };
 
 #endif
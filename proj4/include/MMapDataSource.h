@@ -0,0 +1,36 @@
+#ifndef MMAPDATASOURCE_H
+#define MMAPDATASOURCE_H
+
+#include "DataSource.h"
+#include "MemoryMappedFile.h"
+#include <memory>
+#include <string>
+#include <string_view>
+
+// A data source over a whole file mapped into memory, so reading it is just copying out of the page cache with
+// no stream or system call per read. Contents and Remaining give the bytes themselves for readers that can
+// work on contiguous memory without copying.
+class CMMapDataSource : public CDataSource{
+    private:
+        std::shared_ptr<const CMemoryMappedFile> DFile;
+        std::size_t DOffset;
+    public:
+        CMMapDataSource(const std::string &filename);
+        CMMapDataSource(std::shared_ptr<const CMemoryMappedFile> file);
+
+        //false if the file couldnt be opened or mapped, the source is then just empty
+        bool Valid() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        bool Borrow(std::string_view &chunk, std::size_t max) noexcept override;
+
+        //the whole file, valid for as long as the source is
+        std::string_view Contents() const noexcept;
+        //the part of the file that hasnt been read yet
+        std::string_view Remaining() const noexcept;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MEMORYMAPPEDFILE_H
+#define MEMORYMAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// A whole file mapped read only into memory. The pages come straight from the page cache, so every process that
+// maps the same file shares one physical copy. Data() is page aligned and stays valid until the object is gone.
+class CMemoryMappedFile{
+    private:
+        const char *DData;
+        std::size_t DSize;
+        bool DValid;
+    public:
+        CMemoryMappedFile(const std::string &filename);
+        ~CMemoryMappedFile();
+        CMemoryMappedFile(const CMemoryMappedFile &) = delete;
+        CMemoryMappedFile &operator=(const CMemoryMappedFile &) = delete;
+
+        //false if the file couldnt be opened or mapped
+        bool Valid() const noexcept;
+        const char *Data() const noexcept;
+        std::size_t Size() const noexcept;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef OSMPBFREADER_H
+#define OSMPBFREADER_H
+
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <cstdint>
+#include <utility>
+
+// Decodes an OpenStreetMap PBF file (.osm.pbf) held in memory. The file is a run of blobs, an OSMHeader blob and then
+// OSMData blobs of a few thousand entities each, stored raw or zlib compressed. The constructor only walks the blob
+// headers, every data block is inflated and decoded on its own by DecodeBlock, so different blocks can be decoded on
+// different threads. The memory has to stay alive as long as the reader does.
+class COSMPBFReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        using TTags = std::vector<std::pair<std::string_view, std::string_view>>;
+
+        // Gets the nodes and ways of a block in file order, relations are skipped. The tag views point into the
+        // block being decoded and are only good until the call returns.
+        class CHandler{
+            public:
+                virtual ~CHandler(){};
+                virtual void Node(uint64_t id, double lat, double lon, const TTags &tags) = 0;
+                virtual void Way(uint64_t id, const std::vector<uint64_t> &refs, const TTags &tags) = 0;
+        };
+
+        COSMPBFReader(std::string_view document);
+        ~COSMPBFReader();
+
+        //true if document starts with an OSMHeader blob, an XML document never does
+        static bool IsPBF(std::string_view document) noexcept;
+
+        //false if the header is missing or damaged or needs a feature this reader doesnt have (like history files),
+        //there are no blocks then
+        bool Valid() const noexcept;
+        std::size_t BlockCount() const noexcept;
+        //false if the block is damaged, the handler has then had whatever came before the damage
+        bool DecodeBlock(std::size_t index, CHandler &handler) const;
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "XMLReader.h"
 #include "StreetMap.h"
+#include "DataSource.h"
 #include <memory>
 #include <vector>
 #include <string>
@@ -14,7 +15,37 @@ private:
     std::unique_ptr<SImplementation> DImplementation;
 
 public:
+    //what a filtered load keeps: the ways whose highway tag is one of Highways, the nodes those ways use plus the ones
+    //in Nodes, and of their tags only the keys in WayTags and NodeTags
+    struct SFilter {
+        std::vector<std::string> Highways;
+        std::vector<std::string> WayTags;
+        std::vector<std::string> NodeTags;
+        std::vector<TNodeID> Nodes;
+
+        //the ways a car, bike or walker can use and the way tags the planner reads, no node tags
+        static SFilter Routing();
+    };
+
+    //counts before and after the filter, both the same for a map that wasnt filtered
+    struct SFilterCounts {
+        std::size_t NodesBefore = 0;
+        std::size_t NodesAfter = 0;
+        std::size_t WaysBefore = 0;
+        std::size_t WaysAfter = 0;
+        std::size_t TagsBefore = 0; //node and way tags together
+        std::size_t TagsAfter = 0;
+        std::size_t StringsBefore = 0; //distinct tag keys and values
+        std::size_t StringsAfter = 0;
+    };
+
     COpenStreetMap(std::shared_ptr<CXMLReader> src);
+    //reads the whole OSM document from src and parses pieces of it on up to threads threads (0 for one per core),
+    //then puts them together in file order. the map is the same as parsing it with a CXMLReader.
+    //src can also be a PBF file (.osm.pbf), its blocks are decoded on the threads the same way
+    COpenStreetMap(std::shared_ptr<CDataSource> src, std::size_t threads = 0);
+    //same, but only what filter keeps is left once the document is loaded
+    COpenStreetMap(std::shared_ptr<CDataSource> src, const SFilter &filter, std::size_t threads = 0);
     ~COpenStreetMap();
 
     std::size_t NodeCount() const noexcept override;
@@ -23,6 +54,8 @@ public:
     std::shared_ptr<CStreetMap::SNode> NodeByID(TNodeID id) const noexcept override;
     std::shared_ptr<CStreetMap::SWay> WayByIndex(std::size_t index) const noexcept override;
     std::shared_ptr<CStreetMap::SWay> WayByID(TWayID id) const noexcept override;
+
+    SFilterCounts FilterCounts() const noexcept;
 };
 
 #endif
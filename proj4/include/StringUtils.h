@@ -2,6 +2,7 @@
 #define STRINGUTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace StringUtils{
@@ -21,6 +22,10 @@ std::vector< std::string > Split(const std::string &str, const std::string &splt
 std::string Join(const std::string &str, const std::vector< std::string > &vect) noexcept;
 std::string ExpandTabs(const std::string &str, int tabsize = 4) noexcept;
 int EditDistance(const std::string &left, const std::string &right, bool ignorecase=false) noexcept;
+// stoull for a string_view, so fields can be parsed without making a string: skips leading white space, takes
+// an optional sign and reads digits up to the first non digit, throws std::invalid_argument if there are no
+// digits and std::out_of_range if the value doesnt fit
+unsigned long long ParseUnsigned(std::string_view str);
 
 }
 
@@ -27,8 +27,11 @@ class CTransportationPlanner{
         virtual std::size_t NodeCount() const noexcept = 0;
         virtual std::shared_ptr<CStreetMap::SNode> SortedNodeByIndex(std::size_t index) const noexcept = 0;
 
-        virtual double FindShortestPath(TNodeID src, TNodeID dest, std::vector< TNodeID > &path) = 0;
-        virtual double FindFastestPath(TNodeID src, TNodeID dest, std::vector< TTripStep > &path) = 0;
+        virtual double FindShortestPath(TNodeID src, TNodeID dest, std::vector< TNodeID > &path) const = 0;
+        virtual double FindFastestPath(TNodeID src, TNodeID dest, std::vector< TTripStep > &path) const = 0;
+        //batch versions, result i is for pairs[i]. the queries are spread over threadcount threads (0 means one per core)
+        virtual void FindShortestPaths(const std::vector< std::pair< TNodeID, TNodeID > > &pairs, std::vector< double > &distances, std::vector< std::vector< TNodeID > > &paths, std::size_t threadcount = 0) const = 0;
+        virtual void FindFastestPaths(const std::vector< std::pair< TNodeID, TNodeID > > &pairs, std::vector< double > &times, std::vector< std::vector< TTripStep > > &paths, std::size_t threadcount = 0) const = 0;
         virtual bool GetPathDescription(const std::vector< TTripStep > &path, std::vector< std::string > &desc) const = 0;
 };
 
@@ -11,11 +11,25 @@ class CXMLReader{
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
+        // callbacks for Parse. the names, attributes and text point straight into expat's buffers and are only
+        // valid during the call. attributes is name, value, name, value, ... ending in a null pointer.
+        // text between tags can come in more than one CharacterData call
+        class CHandler{
+            public:
+                virtual ~CHandler(){};
+                virtual void StartElement(const char *name, const char **attributes){};
+                virtual void EndElement(const char *name){};
+                virtual void CharacterData(const char *data, std::size_t length){};
+        };
+
         CXMLReader(std::shared_ptr< CDataSource > src);
         virtual ~CXMLReader();
         
         virtual bool End() const;
         virtual bool ReadEntity(SXMLEntity &entity, bool skipcdata = false);
+        // streams the rest of the document to handler without building any SXMLEntity, anything ReadEntity had
+        // already parsed is passed on first. false if the XML is bad, what a handler throws comes back out of here
+        virtual bool Parse(CHandler &handler);
         //make sure to add virtual
 };
 
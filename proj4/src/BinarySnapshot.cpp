@@ -0,0 +1,119 @@
+#include "BinarySnapshot.h"
+#include <algorithm>
+
+void CSnapshotWriter::Align(){
+    DPayload.resize((DPayload.size() + ArrayAlignment - 1) / ArrayAlignment * ArrayAlignment, 0);
+}
+
+void CSnapshotWriter::WriteString(const std::string &str){
+    Write<uint64_t>(str.size());
+    DPayload.insert(DPayload.end(), str.begin(), str.end());
+}
+
+bool CSnapshotWriter::Finish(std::shared_ptr<CDataSink> sink, const char magic[8], uint32_t version) const{
+    if(!sink){
+        return false;
+    }
+    std::vector<char> Header(magic, magic + 8);
+    auto Append = [&Header](const auto &value){
+        const char *Bytes = reinterpret_cast<const char *>(&value);
+        Header.insert(Header.end(), Bytes, Bytes + sizeof(value));
+    };
+    Append(version);
+    Append(uint32_t(0));
+    Append(uint64_t(DPayload.size()));
+    Append(CSnapshotReader::Checksum(DPayload.data(), DPayload.size()));
+    return sink->Write(Header) && sink->Write(DPayload);
+}
+
+bool CSnapshotReader::CheckHeader(const char *header, const char magic[8], uint32_t version, uint64_t &size, uint64_t &sum) const{
+    uint32_t Version;
+    if(std::memcmp(header, magic, 8)){
+        return false;
+    }
+    std::memcpy(&Version, header + 8, sizeof(Version));
+    std::memcpy(&size, header + 16, sizeof(size));
+    std::memcpy(&sum, header + 24, sizeof(sum));
+    return Version == version;
+}
+
+bool CSnapshotReader::Start(std::shared_ptr<CDataSource> source, const char magic[8], uint32_t version){
+    DPayload.clear();
+    DData = nullptr;
+    DSize = DOffset = 0;
+    std::vector<char> Header;
+    uint64_t Size, Sum;
+    if(!source || !source->Read(Header, CSnapshotWriter::HeaderSize) || Header.size() != CSnapshotWriter::HeaderSize || !CheckHeader(Header.data(), magic, version, Size, Sum)){
+        return false;
+    }
+    //read in blocks so a damaged size cant make us reserve some huge buffer up front
+    const std::size_t BlockSize = 1 << 20;
+    std::vector<char> Block;
+    while(DPayload.size() < Size){
+        if(!source->Read(Block, std::min<uint64_t>(BlockSize, Size - DPayload.size()))){
+            DPayload.clear();
+            return false;
+        }
+        DPayload.insert(DPayload.end(), Block.begin(), Block.end());
+    }
+    if(Checksum(DPayload.data(), DPayload.size()) != Sum){
+        DPayload.clear();
+        return false;
+    }
+    DData = DPayload.data();
+    DSize = DPayload.size();
+    return true;
+}
+
+bool CSnapshotReader::Start(const char *data, std::size_t size, const char magic[8], uint32_t version){
+    DPayload.clear();
+    DData = nullptr;
+    DSize = DOffset = 0;
+    uint64_t Size, Sum;
+    if(!data || size < CSnapshotWriter::HeaderSize || !CheckHeader(data, magic, version, Size, Sum) || Size > size - CSnapshotWriter::HeaderSize){
+        return false;
+    }
+    if(Checksum(data + CSnapshotWriter::HeaderSize, Size) != Sum){
+        return false;
+    }
+    DData = data + CSnapshotWriter::HeaderSize;
+    DSize = Size;
+    return true;
+}
+
+bool CSnapshotReader::Align() noexcept{
+    std::size_t Aligned = (DOffset + CSnapshotWriter::ArrayAlignment - 1) / CSnapshotWriter::ArrayAlignment * CSnapshotWriter::ArrayAlignment;
+    if(Aligned > DSize){
+        return false;
+    }
+    DOffset = Aligned;
+    return true;
+}
+
+bool CSnapshotReader::ReadString(std::string &str){
+    uint64_t Length;
+    if(!Read(Length) || Length > DSize - DOffset){
+        return false;
+    }
+    str.assign(DData + DOffset, Length);
+    DOffset += Length;
+    return true;
+}
+
+std::size_t CSnapshotReader::Offset() const noexcept{
+    return DOffset;
+}
+
+bool CSnapshotReader::Done() const noexcept{
+    return DOffset == DSize;
+}
+
+// 64 bit FNV-1a, catches truncated or damaged files, it is not meant to stop deliberate tampering
+uint64_t CSnapshotReader::Checksum(const char *data, std::size_t size) noexcept{
+    uint64_t Hash = 0xcbf29ce484222325ULL;
+    for(std::size_t Index = 0; Index < size; Index++){
+        Hash ^= static_cast<unsigned char>(data[Index]);
+        Hash *= 0x100000001b3ULL;
+    }
+    return Hash;
+}
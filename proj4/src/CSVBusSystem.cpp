@@ -1,11 +1,13 @@
 
 #include "CSVBusSystem.h"
 #include "DSVReader.h"
+#include "StringUtils.h"
 #include <memory> //provides std::shared_ptr and std::make_shared for memory management
 #include <vector>
 #include <string> // thihs allows use for string:: stuff
 #include <unordered_map>
 #include <iostream> //i need to print bus system details using operator <<
+#include <string_view>
 
 class CCSVBusSystem::SStop : public CBusSystem::SStop
 {
@@ -69,18 +71,19 @@ CCSVBusSystem::CCSVBusSystem(std::shared_ptr<CDSVReader> stopsrc, std::shared_pt
     {
         throw std::invalid_argument("Both stopsrc and routesrc are null");
     }
-    std::vector<std::string> row;
+    // row views so the reader doesnt make a string per field, only the route names get copied
+    std::vector<std::string_view> row;
     if (routesrc)
     {
         std::unordered_map<std::string, std::shared_ptr<SRoute>> tempRoutes;
-        while (routesrc->ReadRow(row))
+        while (routesrc->ReadRowView(row))
         {
             if (row.size() >= 2)
             { // i have ot make sure there is enmnough row s first
                 try
                 {
-                    std::string routeName = row[0];      // first one should be routename
-                    TStopID stopID = std::stoul(row[1]); // second one should be the stop id
+                    std::string routeName(row[0]); // first one should be routename
+                    TStopID stopID = StringUtils::ParseUnsigned(row[1]); // second one should be the stop id
                     auto &route = tempRoutes[routeName];
                     if (!route)
                     {
@@ -105,7 +108,7 @@ CCSVBusSystem::CCSVBusSystem(std::shared_ptr<CDSVReader> stopsrc, std::shared_pt
     }
     if (stopsrc)
     {
-        while (stopsrc->ReadRow(row))//go through every oline
+        while (stopsrc->ReadRowView(row))//go through every oline
         {
             // ensure sufficient columns exists
             if (row.size() >= 2)//make sure enough cokumn are there
@@ -113,8 +116,8 @@ CCSVBusSystem::CCSVBusSystem(std::shared_ptr<CDSVReader> stopsrc, std::shared_pt
                 try
                 {
                     auto stop = std::make_shared<SStop>();
-                    stop->StopID = std::stoul(row[0]);
-                    stop->NodeIDValue = std::stoul(row[1]);
+                    stop->StopID = StringUtils::ParseUnsigned(row[0]);
+                    stop->NodeIDValue = StringUtils::ParseUnsigned(row[1]);
                     DImplementation->Stops[stop->StopID] = stop;
                     DImplementation->StopsByIndex.push_back(stop);
                 }
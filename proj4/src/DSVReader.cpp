@@ -1,49 +1,192 @@
 #include "DSVReader.h"
 #include "DataSource.h"
+#include <string_view>
+#include <cstdint>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 struct CDSVReader::SImplementation {
     std::shared_ptr<CDataSource> source;
     char Delimiter;
+    // the source is taken a chunk at a time, borrowed if it can lend its bytes, otherwise read into ReadBuffer
+    static constexpr size_t ChunkSize = 64 * 1024;
+    std::vector<char> ReadBuffer;
+    std::string_view Chunk; // the part of the current chunk that hasnt been parsed yet
 
     SImplementation(std::shared_ptr<CDataSource> src, char delimiter) : source(src), Delimiter(delimiter) {
     }
 
-    bool ReadRow(std::vector<std::string> &row) {
+    // makes sure there is something left in Chunk, false once the source is used up
+    bool FillChunk() {
+        if (!Chunk.empty()) {
+            return true;
+        }
+        if (source->Borrow(Chunk, ChunkSize)) {
+            return true;
+        }
+        if (source->Read(ReadBuffer, ChunkSize)) {
+            Chunk = std::string_view(ReadBuffer.data(), ReadBuffer.size());
+            return true;
+        }
+        Chunk = std::string_view();
+        return false;
+    }
+
+    bool End() const {
+        return Chunk.empty() && source->End();
+    }
+
+    // length of the run at the start of Chunk that is just field text. inside quotes only a quote ends it, so the
+    // delimiter and newline are swapped for the quote there and every path checks the same three bytes.
+    // with SSE2 (every x86-64) or AVX2 (built with -mavx2) it compares 16 or 32 bytes at a time and the
+    // scalar loop only does the tail
+    size_t PlainRun(bool quoted) const {
+        const char *data = Chunk.data();
+        const size_t size = Chunk.size();
+        const char delimiter = quoted ? '"' : Delimiter;
+        const char newline = quoted ? '"' : '\n';
+        size_t run = 0;
+#if defined(__AVX2__)
+        const __m256i quotes32 = _mm256_set1_epi8('"');
+        const __m256i delimiters32 = _mm256_set1_epi8(delimiter);
+        const __m256i newlines32 = _mm256_set1_epi8(newline);
+        for (; run + 32 <= size; run += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + run));
+            __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quotes32), _mm256_or_si256(_mm256_cmpeq_epi8(bytes, delimiters32), _mm256_cmpeq_epi8(bytes, newlines32)));
+            uint32_t mask = uint32_t(_mm256_movemask_epi8(hits));
+            if (mask) {
+                return run + __builtin_ctz(mask);
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        const __m128i quotes16 = _mm_set1_epi8('"');
+        const __m128i delimiters16 = _mm_set1_epi8(delimiter);
+        const __m128i newlines16 = _mm_set1_epi8(newline);
+        for (; run + 16 <= size; run += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + run));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, quotes16), _mm_or_si128(_mm_cmpeq_epi8(bytes, delimiters16), _mm_cmpeq_epi8(bytes, newlines16)));
+            uint32_t mask = uint32_t(_mm_movemask_epi8(hits));
+            if (mask) {
+                return run + __builtin_ctz(mask);
+            }
+        }
+#endif
+        for (; run < size; run++) {
+            char c = data[run];
+            if (c == '"' || c == delimiter || c == newline) {
+                break;
+            }
+        }
+        return run;
+    }
+
+    // a field of the row being read. while its text is one contiguous run of the current chunk (no doubled
+    // quotes, not split between chunks) it just points there, otherwise it gets copied into RowBuffer
+    struct SField {
+        static constexpr size_t NoOffset = SIZE_MAX;
+        const char *Data = nullptr; // the field in the chunk, null once it is in RowBuffer (or still empty)
+        size_t Offset = NoOffset;   // where it starts in RowBuffer
+        size_t Length = 0;
+    };
+    std::vector<SField> Fields; // the row so far, the last one is the field being read
+    std::string RowBuffer;
+    std::vector<std::string_view> Views; // what the string version of ReadRow reads into
+
+    // copies every field of the row that still points into the chunk into RowBuffer, in order, so the field being
+    // read is always the last thing in RowBuffer once it is there
+    void SpillRow() {
+        for (auto &field : Fields) {
+            if (field.Data) {
+                field.Offset = RowBuffer.size();
+                RowBuffer.append(field.Data, field.Length);
+                field.Data = nullptr;
+            }
+        }
+    }
+
+    // makes sure there is something left in Chunk, false once the source is used up. the old chunk goes away, so
+    // the row's fields are moved out of it first
+    bool NextChunk() {
+        if (Chunk.empty()) {
+            SpillRow();
+        }
+        return FillChunk();
+    }
+
+    // adds the count bytes at text (which are in the chunk) to the field being read
+    void Append(const char *text, size_t count) {
+        SField &field = Fields.back();
+        if (!count) {
+            return;
+        }
+        if (!field.Data && field.Offset == SField::NoOffset) {
+            field.Data = text;
+        } else if (field.Data && field.Data + field.Length != text) {
+            SpillRow();
+        }
+        if (!field.Data) {
+            RowBuffer.append(text, count);
+        }
+        field.Length += count;
+    }
+
+    bool ReadRowView(std::vector<std::string_view> &row) {
 
         row.clear();
-        std::string field;
-        char c;
+        Fields.clear();
+        RowBuffer.clear();
+        Fields.emplace_back();
         bool quoted = false;
+        bool ended = false;
 
-        while (!source->End()) {
-            source->Get(c);
+        while (!ended && NextChunk()) {
+            // take ordinary text over in one go, then handle the quote or separator that ended it
+            size_t run = PlainRun(quoted);
+            Append(Chunk.data(), run);
+            Chunk.remove_prefix(run);
+            if (Chunk.empty()) {
+                continue;
+            }
+            char c = Chunk.front();
+            Chunk.remove_prefix(1);
 
             if (c == '"'){
-                char nc;
-                bool peeked = source->Peek(nc);
-                if (peeked == true && nc == '"'){
-                    source->Get(nc);
-                    field += '"';
-                } else if (quoted == false) {
-                    quoted = true;
+                if (NextChunk() && Chunk.front() == '"'){
+                    Append(Chunk.data(), 1);
+                    Chunk.remove_prefix(1);
                 } else {
-                    quoted = false;
-                }
-            } else if ((c == Delimiter || c == '\n')  && !quoted){
-                row.push_back(field);
-                field.clear();
-                if (c == '\n') {
-                    return true;
+                    quoted = !quoted;
                 }
-            } else { 
-                field += c;
+            } else if (c == '\n') {
+                ended = true;
+            } else {
+                Fields.emplace_back();
             }
         }
-        if (!field.empty() || !row.empty()) { 
-            row.push_back(field);
-            return true;
+        if (!ended && !Fields.back().Length && Fields.size() == 1) {
+            return false;
         }
-        return false;
+        for (auto &field : Fields) {
+            row.push_back(field.Data ? std::string_view(field.Data, field.Length)
+                        : field.Length ? std::string_view(RowBuffer.data() + field.Offset, field.Length)
+                        : std::string_view());
+        }
+        return true;
+    }
+
+    bool ReadRow(std::vector<std::string> &row) {
+        if (!ReadRowView(Views)) {
+            row.clear();
+            return false;
+        }
+        // assign over the strings already in row so their buffers get reused
+        row.resize(Views.size());
+        for (size_t index = 0; index < Views.size(); index++) {
+            row[index].assign(Views[index]);
+        }
+        return true;
     }
 };
 
@@ -53,9 +196,13 @@ CDSVReader::CDSVReader(std::shared_ptr< CDataSource > src, char delimiter) : DIm
 CDSVReader::~CDSVReader() = default;
 
 bool CDSVReader::End() const {
-    return DImplementation->source->End();
+    return DImplementation->End();
 }
 
 bool CDSVReader::ReadRow(std::vector< std::string > &row) {
    return DImplementation->ReadRow(row);
-}
\ No newline at end of file
+}
+
+bool CDSVReader::ReadRowView(std::vector< std::string_view > &row) {
+   return DImplementation->ReadRowView(row);
+}
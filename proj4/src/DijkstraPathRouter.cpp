@@ -1,5 +1,7 @@
 //implement this class
 #include "DijkstraPathRouter.h"
+#include "BinarySnapshot.h"
+#include "MemoryMappedFile.h"
 #include <iostream> 
 #include <algorithm>
 #include <vector>
@@ -8,12 +10,320 @@
 #include <memory> //used for dynamic memory mangaement for shared and unique pointers
 #include <limits>
 #include <string> //enables use of hnadling string data
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
 
 //the cdijkstra path router class will implement the cpathrouter abstract interface - 
 //thecdijkstra path router class will find the shortest path between source and destination vertices if one exists. 
 //the vertex IDs do not have to match node or stop IDS used by the other classes. 
 
+//the scratch space of a query. everything in here is sized to the vertex count the first time it is used and
+//then only reset lazily, so a query only touches the vertices it actually reaches instead of all of them
+struct CDijkstraPathRouter::CQueryContext::SImplementation{
+    //the labels of one search direction, a label only counts if its stamp matches current, so moving on to
+    //the next query is just current++ (and a real clear once every 2^32 queries when it wraps)
+    struct SSearchSide{
+        std::vector<double> dist;
+        std::vector<TVertexID> previous;
+        std::vector<TVertexID> previousmiddle; //only used by the hierarchy search
+        std::vector<double> estimate; //only used by A*
+        std::vector<unsigned int> stamp;
+        unsigned int current = 0;
+
+        void Reset(std::size_t count){
+            if(stamp.size() < count){
+                dist.resize(count);
+                previous.resize(count);
+                previousmiddle.resize(count);
+                estimate.resize(count);
+                stamp.resize(count, 0);
+            }
+            current++;
+            if(current == 0){
+                std::fill(stamp.begin(), stamp.end(), 0);
+                current = 1;
+            }
+        }
+
+        bool Reached(TVertexID v) const noexcept{
+            return stamp[v] == current;
+        }
+
+        double Distance(TVertexID v) const noexcept{
+            return stamp[v] == current ? dist[v] : NoPathExists;
+        }
+
+        void Label(TVertexID v, double distance, TVertexID from, TVertexID middle = InvalidVertexID) noexcept{
+            dist[v] = distance;
+            previous[v] = from;
+            previousmiddle[v] = middle;
+            stamp[v] = current;
+        }
+    };
+
+    //the queues the searches use, plain dijkstra picks one with SetQueuePolicy
+    //they all push (vertex, key) and pop the smallest key, the caller skips entries whose key is bigger than dist
+    //so a queue can either lower the key of a vertex already in it or just add a second entry
+    //Reset empties a queue for the next query but keeps its memory
+
+    //binary heap with lazy deletion, same as std::priority_queue but the vector can be kept between queries
+    struct SBinaryQueue{
+        std::vector<std::pair<double, TVertexID>> heap;
+
+        void Reset(std::size_t count) noexcept{
+            heap.clear();
+        }
+
+        bool Empty() const noexcept{
+            return heap.empty();
+        }
+
+        std::size_t Size() const noexcept{
+            return heap.size();
+        }
+
+        const std::pair<double, TVertexID> &Top() const noexcept{
+            return heap.front();
+        }
+
+        void Push(TVertexID v, double key){
+            heap.push_back(std::make_pair(key, v));
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<double, TVertexID>>());
+        }
+
+        std::pair<double, TVertexID> Pop(){
+            std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<double, TVertexID>>());
+            auto top = heap.back();
+            heap.pop_back();
+            return top;
+        }
+    };
+
+    //4-ary heap that knows where every vertex is, so Push on a queued vertex is a decrease-key and there are
+    //never stale entries. 4 children per node makes it shallower than a binary heap and the children share a cache line
+    struct SQuaternaryHeap{
+        static constexpr std::size_t Arity = 4;
+        static constexpr std::size_t NotQueued = std::numeric_limits<std::size_t>::max();
+        std::vector<std::pair<double, TVertexID>> heap;
+        std::vector<std::size_t> position; //where each vertex is in heap, NotQueued if it isnt
+
+        //only the vertices still in the heap have a position set, so that is all that needs undoing
+        void Reset(std::size_t count){
+            for(auto &entry : heap){
+                position[entry.second] = NotQueued;
+            }
+            heap.clear();
+            if(position.size() < count){
+                position.resize(count, NotQueued);
+            }
+        }
+
+        bool Empty() const noexcept{
+            return heap.empty();
+        }
+
+        void Push(TVertexID v, double key){
+            if(position[v] == NotQueued){
+                position[v] = heap.size();
+                heap.push_back(std::make_pair(key, v));
+            }
+            else if(key < heap[position[v]].first){
+                heap[position[v]].first = key;
+            }
+            else{
+                return;
+            }
+            SiftUp(position[v]);
+        }
+
+        std::pair<double, TVertexID> Pop(){
+            auto top = heap.front();
+            position[top.second] = NotQueued;
+            if(heap.size() > 1){
+                heap.front() = heap.back();
+                position[heap.front().second] = 0;
+            }
+            heap.pop_back();
+            if(!heap.empty()){
+                SiftDown(0);
+            }
+            return top;
+        }
+
+        void SiftUp(std::size_t index){
+            auto entry = heap[index];
+            while(index > 0){
+                std::size_t parent = (index - 1) / Arity;
+                if(heap[parent].first <= entry.first){
+                    break;
+                }
+                heap[index] = heap[parent];
+                position[heap[index].second] = index;
+                index = parent;
+            }
+            heap[index] = entry;
+            position[entry.second] = index;
+        }
+
+        void SiftDown(std::size_t index){
+            auto entry = heap[index];
+            while(true){
+                std::size_t first = index * Arity + 1;
+                if(first >= heap.size()){
+                    break;
+                }
+                std::size_t smallest = first;
+                std::size_t last = std::min(first + Arity, heap.size());
+                for(std::size_t child = first + 1; child < last; child++){
+                    if(heap[child].first < heap[smallest].first){
+                        smallest = child;
+                    }
+                }
+                if(entry.first <= heap[smallest].first){
+                    break;
+                }
+                heap[index] = heap[smallest];
+                position[heap[index].second] = index;
+                index = smallest;
+            }
+            heap[index] = entry;
+            position[entry.second] = index;
+        }
+    };
+
+    //radix heap, it only works because dijkstra never pushes a key smaller than the last one popped (monotone)
+    //the keys are the bit patterns of the distances, for doubles >= 0 those sort the same as the doubles so this
+    //is exact without having to scale the weights to integers. bucket i holds keys whose highest bit different
+    //from the last popped key is bit i - 1, popping only has to look at the first non empty bucket
+    struct SRadixHeap{
+        static constexpr int BucketCount = 65;
+        std::vector<std::pair<uint64_t, TVertexID>> buckets[BucketCount];
+        uint64_t last = 0;
+        std::size_t size = 0;
+
+        void Reset(std::size_t count) noexcept{
+            for(auto &bucket : buckets){
+                bucket.clear();
+            }
+            last = 0;
+            size = 0;
+        }
+
+        static uint64_t ToKey(double distance) noexcept{
+            uint64_t key;
+            std::memcpy(&key, &distance, sizeof(key));
+            return key;
+        }
+
+        static double FromKey(uint64_t key) noexcept{
+            double distance;
+            std::memcpy(&distance, &key, sizeof(distance));
+            return distance;
+        }
+
+        int Bucket(uint64_t key) const noexcept{
+            return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+        }
+
+        bool Empty() const noexcept{
+            return size == 0;
+        }
+
+        void Push(TVertexID v, double key){
+            uint64_t radixkey = ToKey(key);
+            buckets[Bucket(radixkey)].push_back(std::make_pair(radixkey, v));
+            size++;
+        }
+
+        std::pair<double, TVertexID> Pop(){
+            if(buckets[0].empty()){
+                int index = 1;
+                while(buckets[index].empty()){
+                    index++;
+                }
+                //the smallest key of the first non empty bucket becomes last and the bucket gets spread out below it
+                last = std::min_element(buckets[index].begin(), buckets[index].end())->first;
+                for(auto &entry : buckets[index]){
+                    buckets[Bucket(entry.first)].push_back(entry);
+                }
+                buckets[index].clear();
+            }
+            auto entry = buckets[0].back();
+            buckets[0].pop_back();
+            size--;
+            return std::make_pair(FromKey(entry.first), entry.second);
+        }
+    };
+
+    //index 0 is the forward search (and the only one plain dijkstra and A* use), index 1 is the backward search
+    SSearchSide Sides[2];
+    SBinaryQueue BinaryQueues[2];
+    SQuaternaryHeap QuaternaryHeap;
+    SRadixHeap RadixHeap;
+};
+
+//one of the arrays the searches read. it either owns its elements (built by Precompute or copied out of a snapshot)
+//or points into a snapshot file that is mapped into memory, so queries dont care where the graph came from.
+//it only has read access, the builders fill a std::vector and move it in
+template <typename T> class TGraphArray{
+    private:
+        std::vector<T> DOwned;
+        const T *DData = nullptr;
+        std::size_t DSize = 0;
+    public:
+        TGraphArray() = default;
+        TGraphArray(const TGraphArray &) = delete;
+        TGraphArray &operator=(const TGraphArray &) = delete;
+
+        TGraphArray &operator=(std::vector<T> &&values) noexcept{
+            DOwned = std::move(values);
+            DData = DOwned.data();
+            DSize = DOwned.size();
+            return *this;
+        }
+
+        //the memory has to stay mapped for as long as the array uses it
+        void Borrow(const T *data, std::size_t size) noexcept{
+            DOwned = std::vector<T>();
+            DData = data;
+            DSize = size;
+        }
+
+        void clear() noexcept{
+            *this = std::vector<T>();
+        }
+
+        const T &operator[](std::size_t index) const noexcept{
+            return DData[index];
+        }
+
+        const T *data() const noexcept{
+            return DData;
+        }
+
+        std::size_t size() const noexcept{
+            return DSize;
+        }
+
+        bool empty() const noexcept{
+            return DSize == 0;
+        }
+
+        const T *begin() const noexcept{
+            return DData;
+        }
+
+        const T *end() const noexcept{
+            return DData + DSize;
+        }
+};
+
 struct CDijkstraPathRouter::SImplementation{
+    using SWorkspace = CQueryContext::SImplementation;
     
     struct ThisVertex{
         TVertexID ID; //this is the unique id of the vertex
@@ -28,74 +338,1093 @@ struct CDijkstraPathRouter::SImplementation{
             return ID;
         }
 
-        std::any GetTag() const noexcept{
-            return Tag;
+        std::any GetTag() const noexcept{
+            return Tag;
+        }
+
+        //this will return the list of connected neighbors
+        const std::vector<TVertexID> &GetNeighbors() const noexcept{
+            return path;
+        }
+
+        //this will get weight of an edge -> to  anieghbor
+        double GetWeight(TVertexID to) const noexcept{
+            auto it = edges.find(to);
+            if(it != edges.end()){
+                return it->second;
+            }
+            return std::numeric_limits<double>::infinity();
+        }
+
+    };
+
+    std::vector<std::shared_ptr<ThisVertex>> vertices; //this is a vector of shared pointers to the vertices
+    TVertexID nextID = 0; //this is the next id to be assigned to a vertex
+
+    //compressed sparse row (CSR) copy of the graph that the queries actually search
+    //the neighbors of vertex v are EdgeTargets/EdgeWeights[EdgeOffsets[v] .. EdgeOffsets[v + 1])
+    TGraphArray<std::size_t> EdgeOffsets;
+    TGraphArray<TVertexID> EdgeTargets;
+    TGraphArray<double> EdgeWeights;
+    //reverse CSR, the edges coming into v are ReverseSources/ReverseWeights[ReverseOffsets[v] .. ReverseOffsets[v + 1])
+    //only built for the modes that search backward from dest
+    TGraphArray<std::size_t> ReverseOffsets;
+    TGraphArray<TVertexID> ReverseSources;
+    TGraphArray<double> ReverseWeights;
+    //false whenever a vertex or edge was added after the last build. queries that find it false rebuild the CSR
+    //under the mutex, so concurrent const queries on a graph nobody is changing never race on it
+    std::atomic<bool> CompressedValid{false};
+    std::mutex CompressedMutex;
+
+    ESearchMode Mode;
+
+    //per vertex coordinates and the lower bound between two of them, used by A*
+    std::vector<TLocation> Locations;
+    THeuristic Heuristic;
+
+    //ALT (A*, landmarks, triangle inequality)
+    //Precompute picks landmarks spread across the graph and stores the distance from and to each of them, then for
+    //any v and dest, dist(L, dest) - dist(L, v) and dist(v, L) - dist(dest, L) are lower bounds on dist(v, dest)
+    static constexpr std::size_t DefaultLandmarkCount = 8;
+    std::size_t LandmarkTarget = DefaultLandmarkCount; //how many landmarks Precompute tries to pick
+    TGraphArray<TVertexID> Landmarks;
+    TGraphArray<double> FromLandmark; //FromLandmark[v * Landmarks.size() + i] is the distance from landmark i to v
+    TGraphArray<double> ToLandmark; //ToLandmark[v * Landmarks.size() + i] is the distance from v to landmark i
+    bool LandmarksValid = false;
+
+    //plain dijkstra from src over a whole CSR (forward or reverse), false if the deadline passed first
+    static bool SearchAll(TVertexID src, const TGraphArray<std::size_t> &offsets, const TGraphArray<TVertexID> &targets, const TGraphArray<double> &weights, std::vector<double> &dist, std::chrono::steady_clock::time_point deadline){
+        dist.assign(offsets.size() - 1, NoPathExists);
+        std::priority_queue<std::pair<double, TVertexID>, std::vector<std::pair<double, TVertexID>>, std::greater<std::pair<double, TVertexID>>> priorityq;
+        dist[src] = 0;
+        priorityq.push(std::make_pair(0.0, src));
+        std::size_t settled = 0;
+        while(!priorityq.empty()){
+            auto [distance, v] = priorityq.top();
+            priorityq.pop();
+            if(distance > dist[v]){
+                continue;
+            }
+            if(++settled % 4096 == 0 && std::chrono::steady_clock::now() > deadline){
+                return false;
+            }
+            for(std::size_t e = offsets[v]; e < offsets[v + 1]; e++){
+                double newdist = distance + weights[e];
+                if(newdist < dist[targets[e]]){
+                    dist[targets[e]] = newdist;
+                    priorityq.push(std::make_pair(newdist, targets[e]));
+                }
+            }
+        }
+        return true;
+    }
+
+    //picks landmarks farthest first and fills the tables, keeps however many finished if the deadline hits
+    bool BuildLandmarks(std::chrono::steady_clock::time_point deadline){
+        const std::size_t count = vertices.size();
+        Landmarks.clear();
+        FromLandmark.clear();
+        ToLandmark.clear();
+        LandmarksValid = false;
+        if(count == 0){
+            LandmarksValid = true;
+            return true;
+        }
+
+        //start from the vertex with the most edges so we land in the main part of the graph and not on some
+        //little disconnected piece
+        TVertexID seed = 0;
+        for(TVertexID v = 1; v < count; v++){
+            if(EdgeOffsets[v + 1] - EdgeOffsets[v] > EdgeOffsets[seed + 1] - EdgeOffsets[seed]){
+                seed = v;
+            }
+        }
+        //closeness[v] is the distance to v from the nearest landmark picked so far
+        std::vector<double> closeness;
+        bool finished = SearchAll(seed, EdgeOffsets, EdgeTargets, EdgeWeights, closeness, deadline);
+        std::vector<std::vector<double>> from, to;
+        std::vector<TVertexID> landmarks;
+        while(finished && landmarks.size() < LandmarkTarget){
+            TVertexID landmark = InvalidVertexID;
+            for(TVertexID v = 0; v < count; v++){
+                if(closeness[v] != NoPathExists && closeness[v] > 0 && (landmark == InvalidVertexID || closeness[v] > closeness[landmark])){
+                    landmark = v;
+                }
+            }
+            if(landmark == InvalidVertexID){
+                break; //every reachable vertex is already a landmark
+            }
+            std::vector<double> fromdist, todist;
+            if(!SearchAll(landmark, EdgeOffsets, EdgeTargets, EdgeWeights, fromdist, deadline) || !SearchAll(landmark, ReverseOffsets, ReverseSources, ReverseWeights, todist, deadline)){
+                finished = false;
+                break;
+            }
+            for(TVertexID v = 0; v < count; v++){
+                closeness[v] = std::min(closeness[v], fromdist[v]);
+            }
+            landmarks.push_back(landmark);
+            from.push_back(std::move(fromdist));
+            to.push_back(std::move(todist));
+        }
+
+        //store vertex major so one lookup reads all the landmarks of a vertex together
+        const std::size_t landmarkcount = landmarks.size();
+        std::vector<double> fromlandmark(count * landmarkcount), tolandmark(count * landmarkcount);
+        for(TVertexID v = 0; v < count; v++){
+            for(std::size_t i = 0; i < landmarkcount; i++){
+                fromlandmark[v * landmarkcount + i] = from[i][v];
+                tolandmark[v * landmarkcount + i] = to[i][v];
+            }
+        }
+        Landmarks = std::move(landmarks);
+        FromLandmark = std::move(fromlandmark);
+        ToLandmark = std::move(tolandmark);
+        LandmarksValid = true;
+        return finished;
+    }
+
+    //the best triangle inequality bound on dist(v, dest) over all landmarks
+    double LandmarkBound(TVertexID v, TVertexID dest) const noexcept{
+        const std::size_t landmarkcount = Landmarks.size();
+        const double *fromv = FromLandmark.data() + v * landmarkcount;
+        const double *fromdest = FromLandmark.data() + dest * landmarkcount;
+        const double *tov = ToLandmark.data() + v * landmarkcount;
+        const double *todest = ToLandmark.data() + dest * landmarkcount;
+        double bound = 0;
+        for(std::size_t i = 0; i < landmarkcount; i++){
+            if(fromv[i] != NoPathExists && fromdest[i] != NoPathExists){
+                bound = std::max(bound, fromdest[i] - fromv[i]);
+            }
+            if(tov[i] != NoPathExists && todest[i] != NoPathExists){
+                bound = std::max(bound, tov[i] - todest[i]);
+            }
+        }
+        return bound;
+    }
+
+    //contraction hierarchies (CH)
+    //Precompute contracts the vertices one at a time from least to most important, adding a shortcut edge
+    //around a contracted vertex whenever no other path (a witness) is as short. after that a query only has
+    //to search upward in rank from both ends and the two searches meet at the highest vertex of the path.
+    static constexpr std::size_t WitnessSettleLimit = 500; //how many vertices a witness search may settle before giving up
+    static constexpr std::size_t DeadlineCheckInterval = 32; //how many contractions between looking at the clock
+
+    struct SHierarchyEdge{
+        TVertexID Target;
+        double Weight;
+        TVertexID Middle; //the vertex a shortcut skips over, InvalidVertexID for an edge of the original graph
+    };
+
+    TGraphArray<std::size_t> Rank; //the order the vertex was contracted in
+    TGraphArray<std::size_t> UpOffsets; //CSR of the edges v->w with Rank[w] > Rank[v], stored at v
+    TGraphArray<SHierarchyEdge> UpEdges;
+    TGraphArray<std::size_t> DownOffsets; //CSR of the edges u->v with Rank[u] > Rank[v], stored at v with Target u
+    TGraphArray<SHierarchyEdge> DownEdges;
+    bool HierarchyValid = false;
+
+    //a small dijkstra used while contracting, it uses stamps so it doesnt have to reset the whole dist array each time
+    struct SWitnessSearch{
+        std::vector<double> dist;
+        std::vector<unsigned int> stamp;
+        unsigned int current = 0;
+
+        SWitnessSearch(std::size_t count) : dist(count, NoPathExists), stamp(count, 0){
+        }
+
+        double Distance(TVertexID v) const noexcept{
+            return stamp[v] == current ? dist[v] : NoPathExists;
+        }
+
+        //finds distances from src without going through skip, stopping at maxdist or after WitnessSettleLimit vertices
+        void Search(const std::vector<std::vector<SHierarchyEdge>> &out, const std::vector<bool> &contracted, TVertexID src, TVertexID skip, double maxdist){
+            current++;
+            std::priority_queue<std::pair<double, TVertexID>, std::vector<std::pair<double, TVertexID>>, std::greater<std::pair<double, TVertexID>>> priorityq;
+            dist[src] = 0;
+            stamp[src] = current;
+            priorityq.push(std::make_pair(0.0, src));
+            std::size_t settled = 0;
+            while(!priorityq.empty()){
+                auto [distance, v] = priorityq.top();
+                priorityq.pop();
+                if(distance > Distance(v)){
+                    continue;
+                }
+                if(distance > maxdist || ++settled > WitnessSettleLimit){
+                    break;
+                }
+                for(auto &edge : out[v]){
+                    if(contracted[edge.Target] || edge.Target == skip){
+                        continue;
+                    }
+                    double newdist = distance + edge.Weight;
+                    if(newdist < Distance(edge.Target)){
+                        dist[edge.Target] = newdist;
+                        stamp[edge.Target] = current;
+                        priorityq.push(std::make_pair(newdist, edge.Target));
+                    }
+                }
+            }
+        }
+    };
+
+    //finds the shortcuts (src, dest, weight) that contracting v would need
+    static void FindShortcuts(TVertexID v, const std::vector<std::vector<SHierarchyEdge>> &out, const std::vector<std::vector<SHierarchyEdge>> &in, const std::vector<bool> &contracted, SWitnessSearch &witness, std::vector<std::tuple<TVertexID, TVertexID, double>> &shortcuts){
+        shortcuts.clear();
+        for(auto &inedge : in[v]){
+            TVertexID u = inedge.Target;
+            if(contracted[u]){
+                continue;
+            }
+            double maxout = -1;
+            for(auto &outedge : out[v]){
+                if(!contracted[outedge.Target] && outedge.Target != u){
+                    maxout = std::max(maxout, outedge.Weight);
+                }
+            }
+            if(maxout < 0){
+                continue;
+            }
+            witness.Search(out, contracted, u, v, inedge.Weight + maxout);
+            for(auto &outedge : out[v]){
+                TVertexID w = outedge.Target;
+                if(contracted[w] || w == u){
+                    continue;
+                }
+                double viaweight = inedge.Weight + outedge.Weight;
+                if(witness.Distance(w) > viaweight){
+                    shortcuts.push_back(std::make_tuple(u, w, viaweight));
+                }
+            }
+        }
+    }
+
+    //the priority is the edge difference plus how many neighbors are already gone, so contraction stays spread out
+    static long long ContractionPriority(TVertexID v, const std::vector<std::vector<SHierarchyEdge>> &out, const std::vector<std::vector<SHierarchyEdge>> &in, const std::vector<bool> &contracted, const std::vector<std::size_t> &contractedneighbors, SWitnessSearch &witness, std::vector<std::tuple<TVertexID, TVertexID, double>> &shortcuts){
+        FindShortcuts(v, out, in, contracted, witness, shortcuts);
+        long long degree = 0;
+        for(auto &edge : out[v]){
+            degree += contracted[edge.Target] ? 0 : 1;
+        }
+        for(auto &edge : in[v]){
+            degree += contracted[edge.Target] ? 0 : 1;
+        }
+        return 2 * static_cast<long long>(shortcuts.size()) - degree + static_cast<long long>(contractedneighbors[v]);
+    }
+
+    //adds the edge src->dest, or lowers the weight if the edge is already there
+    static void AddHierarchyEdge(std::vector<std::vector<SHierarchyEdge>> &out, std::vector<std::vector<SHierarchyEdge>> &in, TVertexID src, TVertexID dest, double weight, TVertexID middle){
+        for(auto &edge : out[src]){
+            if(edge.Target == dest){
+                if(weight < edge.Weight){
+                    edge.Weight = weight;
+                    edge.Middle = middle;
+                    for(auto &inedge : in[dest]){
+                        if(inedge.Target == src){
+                            inedge.Weight = weight;
+                            inedge.Middle = middle;
+                        }
+                    }
+                }
+                return;
+            }
+        }
+        out[src].push_back({dest, weight, middle});
+        in[dest].push_back({src, weight, middle});
+    }
+
+    //builds the hierarchy from the CSR graph, returns false if the deadline passed first
+    bool BuildHierarchy(std::chrono::steady_clock::time_point deadline){
+        const std::size_t count = vertices.size();
+        std::vector<std::vector<SHierarchyEdge>> out(count), in(count);
+        for(TVertexID v = 0; v < count; v++){
+            for(std::size_t e = EdgeOffsets[v]; e < EdgeOffsets[v + 1]; e++){
+                if(EdgeTargets[e] != v){
+                    out[v].push_back({EdgeTargets[e], EdgeWeights[e], InvalidVertexID});
+                    in[EdgeTargets[e]].push_back({v, EdgeWeights[e], InvalidVertexID});
+                }
+            }
+        }
+
+        std::vector<bool> contracted(count, false);
+        std::vector<std::size_t> contractedneighbors(count, 0);
+        std::vector<std::tuple<TVertexID, TVertexID, double>> shortcuts;
+        SWitnessSearch witness(count);
+        std::vector<std::size_t> rank(count, 0);
+
+        //initial ordering
+        std::priority_queue<std::pair<long long, TVertexID>, std::vector<std::pair<long long, TVertexID>>, std::greater<std::pair<long long, TVertexID>>> order;
+        for(TVertexID v = 0; v < count; v++){
+            if(v % DeadlineCheckInterval == 0 && std::chrono::steady_clock::now() > deadline){
+                return false;
+            }
+            order.push(std::make_pair(ContractionPriority(v, out, in, contracted, contractedneighbors, witness, shortcuts), v));
+        }
+
+        //contract with lazy updates, a vertex whose priority got worse goes back in the queue
+        std::size_t nextrank = 0;
+        while(!order.empty()){
+            if(nextrank % DeadlineCheckInterval == 0 && std::chrono::steady_clock::now() > deadline){
+                return false;
+            }
+            TVertexID v = order.top().second;
+            order.pop();
+            long long priority = ContractionPriority(v, out, in, contracted, contractedneighbors, witness, shortcuts);
+            if(!order.empty() && priority > order.top().first){
+                order.push(std::make_pair(priority, v));
+                continue;
+            }
+            for(auto &[src, dest, weight] : shortcuts){
+                AddHierarchyEdge(out, in, src, dest, weight, v);
+            }
+            contracted[v] = true;
+            rank[v] = nextrank++;
+            for(auto &edge : out[v]){
+                contractedneighbors[edge.Target]++;
+            }
+            for(auto &edge : in[v]){
+                contractedneighbors[edge.Target]++;
+            }
+        }
+
+        //split every edge into the upward graph of its lower end
+        std::vector<std::size_t> upoffsets(count + 1, 0), downoffsets(count + 1, 0);
+        for(TVertexID v = 0; v < count; v++){
+            for(auto &edge : out[v]){
+                if(rank[edge.Target] > rank[v]){
+                    upoffsets[v + 1]++;
+                }
+                else{
+                    downoffsets[edge.Target + 1]++;
+                }
+            }
+        }
+        for(TVertexID v = 0; v < count; v++){
+            upoffsets[v + 1] += upoffsets[v];
+            downoffsets[v + 1] += downoffsets[v];
+        }
+        std::vector<SHierarchyEdge> upedges(upoffsets[count]), downedges(downoffsets[count]);
+        std::vector<std::size_t> upfill(upoffsets.begin(), upoffsets.end() - 1);
+        std::vector<std::size_t> downfill(downoffsets.begin(), downoffsets.end() - 1);
+        for(TVertexID v = 0; v < count; v++){
+            for(auto &edge : out[v]){
+                if(rank[edge.Target] > rank[v]){
+                    upedges[upfill[v]++] = edge;
+                }
+                else{
+                    downedges[downfill[edge.Target]++] = {v, edge.Weight, edge.Middle};
+                }
+            }
+        }
+        Rank = std::move(rank);
+        UpOffsets = std::move(upoffsets);
+        UpEdges = std::move(upedges);
+        DownOffsets = std::move(downoffsets);
+        DownEdges = std::move(downedges);
+        HierarchyValid = true;
+        return true;
+    }
+
+    //finds the vertex the hierarchy edge src->dest skips over
+    TVertexID HierarchyMiddle(TVertexID src, TVertexID dest) const noexcept{
+        if(Rank[src] < Rank[dest]){
+            for(std::size_t e = UpOffsets[src]; e < UpOffsets[src + 1]; e++){
+                if(UpEdges[e].Target == dest){
+                    return UpEdges[e].Middle;
+                }
+            }
+        }
+        else{
+            for(std::size_t e = DownOffsets[dest]; e < DownOffsets[dest + 1]; e++){
+                if(DownEdges[e].Target == src){
+                    return DownEdges[e].Middle;
+                }
+            }
+        }
+        return InvalidVertexID;
+    }
+
+    //appends the original vertices of the hierarchy edge src->dest to path (without src)
+    void UnpackHierarchyEdge(TVertexID src, TVertexID dest, TVertexID middle, std::vector<TVertexID> &path) const{
+        std::vector<std::tuple<TVertexID, TVertexID, TVertexID>> stack;
+        stack.push_back(std::make_tuple(src, dest, middle));
+        while(!stack.empty()){
+            auto [from, to, via] = stack.back();
+            stack.pop_back();
+            if(via == InvalidVertexID){
+                path.push_back(to);
+            }
+            else{
+                //second half goes on first so the first half comes off the stack first
+                stack.push_back(std::make_tuple(via, to, HierarchyMiddle(via, to)));
+                stack.push_back(std::make_tuple(from, via, HierarchyMiddle(from, via)));
+            }
+        }
+    }
+
+    //bidirectional upward search on the hierarchy, every source starts the forward search at its seed distance and
+    //every target the backward one
+    double FindShortestPathHierarchy(const TSeeds &sources, const TSeeds &targets, std::vector<TVertexID> &path, SWorkspace &workspace){
+        path.clear();
+
+        //index 0 is the forward search from src, index 1 is the backward search from dest
+        auto &sides = workspace.Sides;
+        auto &priorityq = workspace.BinaryQueues;
+        const TGraphArray<std::size_t> *offsets[2] = {&UpOffsets, &DownOffsets};
+        const TGraphArray<SHierarchyEdge> *edges[2] = {&UpEdges, &DownEdges};
+
+        SeedSides(sources, targets, sides, priorityq);
+        double best = NoPathExists;
+        TVertexID meet = InvalidVertexID;
+
+        while(true){
+            //a side is done once its smallest key cant beat the best meeting point
+            for(int side = 0; side < 2; side++){
+                if(!priorityq[side].Empty() && priorityq[side].Top().first >= best){
+                    priorityq[side].Reset(vertices.size());
+                }
+            }
+            if(priorityq[0].Empty() && priorityq[1].Empty()){
+                break;
+            }
+            int side = priorityq[1].Empty() || (!priorityq[0].Empty() && priorityq[0].Top().first <= priorityq[1].Top().first) ? 0 : 1;
+            auto [distance, v] = priorityq[side].Pop();
+            if(distance > sides[side].Distance(v)){
+                continue;
+            }
+            if(sides[1 - side].Reached(v) && distance + sides[1 - side].dist[v] < best){
+                best = distance + sides[1 - side].dist[v];
+                meet = v;
+            }
+            for(std::size_t e = (*offsets[side])[v]; e < (*offsets[side])[v + 1]; e++){
+                auto &edge = (*edges[side])[e];
+                double newdist = distance + edge.Weight;
+                if(newdist < sides[side].Distance(edge.Target)){
+                    sides[side].Label(edge.Target, newdist, v, edge.Middle);
+                    priorityq[side].Push(edge.Target, newdist);
+                }
+            }
+        }
+
+        if(meet == InvalidVertexID){
+            return NoPathExists;
+        }
+
+        //source ... meet comes from the forward search, walked backwards and then unpacked in order
+        std::vector<TVertexID> forwardchain;
+        TVertexID at = meet;
+        for(; sides[0].previous[at] != InvalidVertexID; at = sides[0].previous[at]){
+            forwardchain.push_back(at);
+        }
+        path.push_back(at);
+        for(auto it = forwardchain.rbegin(); it != forwardchain.rend(); it++){
+            UnpackHierarchyEdge(at, *it, sides[0].previousmiddle[*it], path);
+            at = *it;
+        }
+        //meet ... target comes from the backward search, which already points toward the target
+        for(at = meet; sides[1].previous[at] != InvalidVertexID; at = sides[1].previous[at]){
+            UnpackHierarchyEdge(at, sides[1].previous[at], sides[1].previousmiddle[at], path);
+        }
+        return best;
+    }
+
+    //labels the seeds of both sides of a bidirectional search and queues them, a seed listed twice keeps the
+    //smaller distance and seeds that arent vertices are left out
+    void SeedSides(const TSeeds &sources, const TSeeds &targets, SWorkspace::SSearchSide *sides, SWorkspace::SBinaryQueue *priorityq) const{
+        const TSeeds *seeds[2] = {&sources, &targets};
+        for(int side = 0; side < 2; side++){
+            sides[side].Reset(vertices.size());
+            priorityq[side].Reset(vertices.size());
+            for(auto &[vertex, distance] : *seeds[side]){
+                if(vertex < vertices.size() && distance < sides[side].Distance(vertex)){
+                    sides[side].Label(vertex, distance, InvalidVertexID);
+                    priorityq[side].Push(vertex, distance);
+                }
+            }
+        }
+    }
+
+    CQueryContext DefaultContext; //used by the FindShortestPath that doesnt take a context
+
+    SImplementation(ESearchMode mode) : Mode(mode){
+    }
+
+    std::size_t VertexCount() const noexcept{//this funcitno returns number of vertices in graph 
+        return vertices.size();
+    }
+    
+    //now must create a a new vertex to a grpah 
+    TVertexID AddVertex(std::any tag) noexcept{
+        RestoreVertexEdges();
+        auto newVertex = std::make_shared<ThisVertex>();
+        newVertex->ID = nextID;
+        newVertex->Tag = tag;
+        vertices.push_back(newVertex);
+        nextID++;
+        CompressedValid = false;
+        HierarchyValid = false;
+        LandmarksValid = false;
+        return newVertex->ID;
+    }
+
+    //if the tag exists it returns the tag of a vertex
+    std::any GetVertexTag(TVertexID id) const noexcept {
+        if (id < vertices.size()){
+            return vertices[id]->GetTag();
+        }
+        return std::any();
+    }
+
+    //this adds weighted edge between the src and dest given
+    bool AddEdge(TVertexID src, TVertexID dest, double weight, bool bidir = false) noexcept{
+        if(src >= vertices.size() || dest >= vertices.size() || weight < 0){
+            return false;
+        }
+        RestoreVertexEdges();
+
+        vertices[src]->edges[dest] = weight; // add weight from src to dest 
+        vertices[src]->path.push_back(dest); // add directed edge to path vector
+
+        if(bidir){ // if the path can be traversed both ways, add weight from dest to src
+            vertices[dest]->edges[src] = weight;
+            vertices[dest]->path.push_back(src); // add directed edge to path vector
+        }
+
+        CompressedValid = false;
+        HierarchyValid = false;
+        LandmarksValid = false;
+        return true;
+    }
+
+    //this flattens the per vertex edge maps into the CSR arrays
+    //repeated AddEdge calls for the same src/dest keep one entry with the last weight, same as the edges map
+    void BuildCompressedGraph(){
+        RestoreVertexEdges(); //a loaded graph only has its edges in the CSR
+        std::vector<std::size_t> offsets(vertices.size() + 1, 0);
+        std::vector<TVertexID> targets;
+        std::vector<double> weights;
+
+        std::size_t edgeCount = 0;
+        for(auto &vertex : vertices){
+            edgeCount += vertex->edges.size();
+        }
+        targets.reserve(edgeCount);
+        weights.reserve(edgeCount);
+
+        //seen[n] == v + 1 means n is already in the slice of v, so we dont need to clear it between vertices
+        std::vector<TVertexID> seen(vertices.size(), 0);
+        for(TVertexID v = 0; v < vertices.size(); v++){
+            offsets[v] = targets.size();
+            for(TVertexID neighbor : vertices[v]->GetNeighbors()){
+                if(seen[neighbor] == v + 1){
+                    continue;
+                }
+                seen[neighbor] = v + 1;
+                targets.push_back(neighbor);
+                weights.push_back(vertices[v]->GetWeight(neighbor));
+            }
+        }
+        offsets[vertices.size()] = targets.size();
+        EdgeOffsets = std::move(offsets);
+        EdgeTargets = std::move(targets);
+        EdgeWeights = std::move(weights);
+
+        if(Mode == ESearchMode::Bidirectional || Mode == ESearchMode::Landmarks){
+            BuildReverseGraph();
+        }
+        CompressedValid = true;
+    }
+
+    void EnsureCompressedGraph(){
+        if(!CompressedValid){
+            std::lock_guard<std::mutex> lock(CompressedMutex);
+            if(!CompressedValid){
+                BuildCompressedGraph();
+            }
+        }
+    }
+
+    //this transposes the CSR arrays, counting in edges first and then filling each slice in order
+    void BuildReverseGraph(){
+        std::vector<std::size_t> offsets(vertices.size() + 1, 0);
+        for(TVertexID target : EdgeTargets){
+            offsets[target + 1]++;
+        }
+        for(std::size_t v = 0; v < vertices.size(); v++){
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<TVertexID> sources(EdgeTargets.size());
+        std::vector<double> weights(EdgeTargets.size());
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for(TVertexID v = 0; v < vertices.size(); v++){
+            for(std::size_t e = EdgeOffsets[v]; e < EdgeOffsets[v + 1]; e++){
+                std::size_t slot = fill[EdgeTargets[e]]++;
+                sources[slot] = v;
+                weights[slot] = EdgeWeights[e];
+            }
+        }
+        ReverseOffsets = std::move(offsets);
+        ReverseSources = std::move(sources);
+        ReverseWeights = std::move(weights);
+    }
+
+    bool Precompute(std::chrono::steady_clock::time_point deadline) noexcept{
+        //building the CSR is linear in the graph size so it is done even if the deadline already passed
+        try{
+            BuildCompressedGraph();
+            if(Mode == ESearchMode::ContractionHierarchies && !HierarchyValid){
+                //if the deadline hits first the hierarchy is left invalid and queries fall back to dijkstra
+                return BuildHierarchy(deadline);
+            }
+            if(Mode == ESearchMode::Landmarks && !LandmarksValid){
+                return BuildLandmarks(deadline);
+            }
+        }
+        catch(...){
+            CompressedValid = false;
+            HierarchyValid = false;
+            LandmarksValid = false;
+            return false;
+        }
+        return std::chrono::steady_clock::now() <= deadline;
+    }
+
+    //true if queries go through A*, the AStar and Landmarks modes and ContractionHierarchies when the hierarchy
+    //didnt finish do if there is a bound
+    bool UsesAStar() const noexcept{
+        bool landmarks = Mode == ESearchMode::Landmarks && LandmarksValid;
+        return landmarks || (Heuristic && Mode != ESearchMode::Dijkstra && Mode != ESearchMode::Bidirectional && !(Mode == ESearchMode::ContractionHierarchies && HierarchyValid));
+    }
+
+    double FindShortestPath(TVertexID src, TVertexID dest, std::vector<TVertexID> &path, SWorkspace &workspace) noexcept{
+        try{
+            if(Mode == ESearchMode::ContractionHierarchies && HierarchyValid){
+                if(src >= vertices.size() || dest >= vertices.size()){
+                    path.clear();
+                    return NoPathExists;
+                }
+                return FindShortestPathHierarchy({{src, 0.0}}, {{dest, 0.0}}, path, workspace);
+            }
+            if(UsesAStar()){
+                return FindShortestPathAStar(src, dest, path, workspace);
+            }
+            if(Mode == ESearchMode::Bidirectional){
+                if(src >= vertices.size() || dest >= vertices.size()){
+                    path.clear();
+                    return NoPathExists;
+                }
+                return FindShortestPathBidirectional({{src, 0.0}}, {{dest, 0.0}}, path, workspace);
+            }
+        }
+        catch(...){
+            path.clear();
+            return NoPathExists;
+        }
+        return FindShortestPathDijkstra(src, dest, path, workspace);
+    }
+
+    //the hierarchy and bidirectional searches start from all the seeds at once, A* and plain dijkstra are aimed at
+    //one target so they try every source and target pair (there are only a couple when the seeds are the ends of a
+    //contracted edge)
+    double FindShortestPath(const TSeeds &sources, const TSeeds &targets, std::vector<TVertexID> &path, SWorkspace &workspace) noexcept{
+        try{
+            if(Mode == ESearchMode::ContractionHierarchies && HierarchyValid){
+                return FindShortestPathHierarchy(sources, targets, path, workspace);
+            }
+            if(!UsesAStar() && Mode == ESearchMode::Bidirectional){
+                return FindShortestPathBidirectional(sources, targets, path, workspace);
+            }
+            double best = NoPathExists;
+            std::vector<TVertexID> candidate;
+            path.clear();
+            for(auto &[src, srcdistance] : sources){
+                for(auto &[dest, destdistance] : targets){
+                    double distance = FindShortestPath(src, dest, candidate, workspace);
+                    if(distance != NoPathExists && srcdistance + distance + destdistance < best){
+                        best = srcdistance + distance + destdistance;
+                        path.swap(candidate);
+                    }
+                }
+            }
+            return best;
+        }
+        catch(...){
+            path.clear();
+            return NoPathExists;
         }
+    }
 
-        //this will return the list of connected neighbors
-        std::vector<TVertexID> GetNeighbors() const noexcept{
-            return path;
+    //snapshots hold the built graph, the CSR arrays plus the hierarchy and landmarks if they are valid
+    //the tags (std::any) and the heuristic function cant be written out, so a loaded router has empty tags and no heuristic
+    static constexpr char SnapshotMagic[8] = {'C', 'D', 'P', 'R', 'S', 'N', 'A', 'P'};
+    static constexpr uint32_t SnapshotVersion = 2;
+
+    //true after Load, the per vertex edge maps are still empty and only get filled from the CSR if the graph is changed
+    bool VertexEdgesPending = false;
+    //the snapshot file the graph arrays point into, if the router was made from a mapped snapshot
+    std::shared_ptr<const CMemoryMappedFile> Mapping;
+
+    void RestoreVertexEdges(){
+        if(!VertexEdgesPending){
+            return;
+        }
+        for(TVertexID v = 0; v < vertices.size(); v++){
+            for(std::size_t e = EdgeOffsets[v]; e < EdgeOffsets[v + 1]; e++){
+                vertices[v]->edges[EdgeTargets[e]] = EdgeWeights[e];
+                vertices[v]->path.push_back(EdgeTargets[e]);
+            }
         }
+        VertexEdgesPending = false;
+    }
 
-        //this will get weight of an edge -> to  anieghbor
-        double GetWeight(TVertexID to) const noexcept{
-            auto it = edges.find(to);
-            if(it != edges.end()){
-                return it->second;
+    template <typename T> static void WriteArray(CSnapshotWriter &writer, const TGraphArray<T> &array){
+        writer.WriteArray(array.data(), array.size());
+    }
+
+    bool Save(std::shared_ptr<CDataSink> sink) noexcept{
+        try{
+            EnsureCompressedGraph();
+            CSnapshotWriter writer;
+            writer.Write<uint32_t>(uint32_t(Mode));
+            writer.Write<uint32_t>(uint32_t(QueuePolicy));
+            writer.Write<uint64_t>(LandmarkTarget);
+            writer.Write<uint64_t>(vertices.size());
+            WriteArray(writer, EdgeOffsets);
+            WriteArray(writer, EdgeTargets);
+            WriteArray(writer, EdgeWeights);
+            WriteArray(writer, ReverseOffsets);
+            WriteArray(writer, ReverseSources);
+            WriteArray(writer, ReverseWeights);
+            writer.Write<uint8_t>(LandmarksValid);
+            if(LandmarksValid){
+                WriteArray(writer, Landmarks);
+                WriteArray(writer, FromLandmark);
+                WriteArray(writer, ToLandmark);
             }
-            return std::numeric_limits<double>::infinity();
+            writer.Write<uint8_t>(HierarchyValid);
+            if(HierarchyValid){
+                WriteArray(writer, Rank);
+                WriteArray(writer, UpOffsets);
+                WriteArray(writer, UpEdges);
+                WriteArray(writer, DownOffsets);
+                WriteArray(writer, DownEdges);
+            }
+            return writer.Finish(sink, SnapshotMagic, SnapshotVersion);
+        }
+        catch(...){
+            return false;
+        }
+    }
+
+    //an array as it sits in the snapshot payload
+    template <typename T> struct SSnapshotArray{
+        const T *Data = nullptr;
+        std::size_t Size = 0;
+
+        bool Read(CSnapshotReader &reader){
+            return reader.ReadArray(Data, Size);
         }
 
+        const T &operator[](std::size_t index) const noexcept{
+            return Data[index];
+        }
+
+        //points the graph array into the payload when it is mapped, copies it out otherwise
+        void MoveTo(TGraphArray<T> &array, bool mapped) const{
+            if(mapped){
+                array.Borrow(Data, Size);
+            }
+            else{
+                array = std::vector<T>(Data, Data + Size);
+            }
+        }
     };
 
-    std::vector<std::shared_ptr<ThisVertex>> vertices; //this is a vector of shared pointers to the vertices
-    TVertexID nextID; //this is the next id to be assigned to a vertex
+    //offsets has to be a CSR over count vertices with edgecount edges, all of them going to real vertices
+    template <typename TTarget> static bool ValidCSR(const SSnapshotArray<std::size_t> &offsets, std::size_t edgecount, std::size_t count, TTarget target){
+        if(offsets.Size != count + 1 || offsets[0] != 0 || offsets[count] != edgecount){
+            return false;
+        }
+        for(std::size_t v = 0; v < count; v++){
+            if(offsets[v] > offsets[v + 1]){
+                return false;
+            }
+        }
+        for(std::size_t e = 0; e < edgecount; e++){
+            if(target(e) >= count){
+                return false;
+            }
+        }
+        return true;
+    }
 
-    std::size_t VertexCount() const noexcept{//this funcitno returns number of vertices in graph 
-        return vertices.size();
+    static bool ValidCSR(const SSnapshotArray<std::size_t> &offsets, const SSnapshotArray<TVertexID> &targets, std::size_t weightcount, std::size_t count){
+        return weightcount == targets.Size && ValidCSR(offsets, targets.Size, count, [&targets](std::size_t e){ return targets[e]; });
     }
-    
-    //now must create a a new vertex to a grpah 
-    TVertexID AddVertex(std::any tag) noexcept{
-        auto newVertex = std::make_shared<ThisVertex>();
-        newVertex->ID = nextID;
-        newVertex->Tag = tag;
-        vertices.push_back(newVertex);
-        nextID++;
-        return newVertex->ID;
+
+    static bool ValidHierarchyCSR(const SSnapshotArray<std::size_t> &offsets, const SSnapshotArray<SHierarchyEdge> &edges, std::size_t count){
+        for(std::size_t e = 0; e < edges.Size; e++){
+            if(edges[e].Middle != InvalidVertexID && edges[e].Middle >= count){
+                return false;
+            }
+        }
+        return ValidCSR(offsets, edges.Size, count, [&edges](std::size_t e){ return edges[e].Target; });
     }
 
-    //if the tag exists it returns the tag of a vertex
-    std::any GetVertexTag(TVertexID id) const noexcept {
-        if (id < vertices.size()){
-            return vertices[id]->GetTag();
+    //reads and checks everything before touching the router so a bad snapshot leaves it as it was
+    //with mapping set the graph arrays point into the mapped file, otherwise they are copied out of the reader
+    bool LoadSnapshot(CSnapshotReader &reader, std::shared_ptr<const CMemoryMappedFile> mapping){
+        uint32_t mode, policy;
+        uint64_t landmarktarget, count;
+        SSnapshotArray<std::size_t> offsets, reverseoffsets, rank, upoffsets, downoffsets;
+        SSnapshotArray<TVertexID> targets, reversesources, landmarks;
+        SSnapshotArray<double> weights, reverseweights, fromlandmark, tolandmark;
+        SSnapshotArray<SHierarchyEdge> upedges, downedges;
+        uint8_t landmarksvalid, hierarchyvalid;
+        if(!reader.Read(mode) || !reader.Read(policy) || !reader.Read(landmarktarget) || !reader.Read(count)
+            || mode > uint32_t(ESearchMode::ContractionHierarchies) || policy > uint32_t(EQueuePolicy::RadixHeap)
+            || !offsets.Read(reader) || !targets.Read(reader) || !weights.Read(reader)
+            || !ValidCSR(offsets, targets, weights.Size, count)
+            || !reverseoffsets.Read(reader) || !reversesources.Read(reader) || !reverseweights.Read(reader)
+            || !reader.Read(landmarksvalid)){
+            return false;
         }
-        return std::any();
+        bool reverse = reverseoffsets.Size;
+        if(reverse && !ValidCSR(reverseoffsets, reversesources, reverseweights.Size, count)){
+            return false;
+        }
+        if(landmarksvalid){
+            if(!landmarks.Read(reader) || !fromlandmark.Read(reader) || !tolandmark.Read(reader)
+                || fromlandmark.Size != count * landmarks.Size || tolandmark.Size != fromlandmark.Size){
+                return false;
+            }
+            for(std::size_t i = 0; i < landmarks.Size; i++){
+                if(landmarks[i] >= count){
+                    return false;
+                }
+            }
+        }
+        if(!reader.Read(hierarchyvalid)){
+            return false;
+        }
+        if(hierarchyvalid){
+            if(!rank.Read(reader) || !upoffsets.Read(reader) || !upedges.Read(reader)
+                || !downoffsets.Read(reader) || !downedges.Read(reader) || rank.Size != count
+                || !ValidHierarchyCSR(upoffsets, upedges, count) || !ValidHierarchyCSR(downoffsets, downedges, count)){
+                return false;
+            }
+        }
+        //the searches that go backward need the reverse CSR
+        if(!reader.Done() || ((ESearchMode(mode) == ESearchMode::Bidirectional || ESearchMode(mode) == ESearchMode::Landmarks) && !reverse)){
+            return false;
+        }
+
+        std::vector<std::shared_ptr<ThisVertex>> loaded;
+        loaded.reserve(count);
+        for(TVertexID v = 0; v < count; v++){
+            loaded.push_back(std::make_shared<ThisVertex>());
+            loaded.back()->ID = v;
+        }
+        const bool mapped = mapping != nullptr;
+        offsets.MoveTo(EdgeOffsets, mapped);
+        targets.MoveTo(EdgeTargets, mapped);
+        weights.MoveTo(EdgeWeights, mapped);
+        reverseoffsets.MoveTo(ReverseOffsets, mapped);
+        reversesources.MoveTo(ReverseSources, mapped);
+        reverseweights.MoveTo(ReverseWeights, mapped);
+        landmarks.MoveTo(Landmarks, mapped);
+        fromlandmark.MoveTo(FromLandmark, mapped);
+        tolandmark.MoveTo(ToLandmark, mapped);
+        rank.MoveTo(Rank, mapped);
+        upoffsets.MoveTo(UpOffsets, mapped);
+        upedges.MoveTo(UpEdges, mapped);
+        downoffsets.MoveTo(DownOffsets, mapped);
+        downedges.MoveTo(DownEdges, mapped);
+        Mapping = std::move(mapping);
+        vertices = std::move(loaded);
+        nextID = count;
+        Mode = ESearchMode(mode);
+        QueuePolicy = EQueuePolicy(policy);
+        LandmarkTarget = landmarktarget;
+        Locations.clear();
+        Heuristic = nullptr;
+        LandmarksValid = landmarksvalid;
+        HierarchyValid = hierarchyvalid;
+        VertexEdgesPending = true;
+        CompressedValid = true;
+        return true;
     }
 
-    //this adds weighted edge between the src and dest given
-    bool AddEdge(TVertexID src, TVertexID dest, double weight, bool bidir = false) const noexcept{
-        if(src >= vertices.size() || dest >= vertices.size() || weight < 0){
+    bool Load(std::shared_ptr<CDataSource> source) noexcept{
+        try{
+            CSnapshotReader reader;
+            return reader.Start(source, SnapshotMagic, SnapshotVersion) && LoadSnapshot(reader, nullptr);
+        }
+        catch(...){
             return false;
         }
+    }
 
-        vertices[src]->edges[dest] = weight; // add weight from src to dest 
-        vertices[src]->path.push_back(dest); // add directed edge to path vector
+    bool Load(std::shared_ptr<const CMemoryMappedFile> file, std::size_t offset, std::size_t size) noexcept{
+        try{
+            CSnapshotReader reader;
+            if(!file || !file->Valid() || offset > file->Size() || size > file->Size() - offset){
+                return false;
+            }
+            return reader.Start(file->Data() + offset, size, SnapshotMagic, SnapshotVersion) && LoadSnapshot(reader, file);
+        }
+        catch(...){
+            return false;
+        }
+    }
 
-        if(bidir){ // if the path can be traversed both ways, add weight from dest to src
-            vertices[dest]->edges[src] = weight;
-            vertices[dest]->path.push_back(src); // add directed edge to path vector
+    void SetLandmarkCount(std::size_t count) noexcept{
+        if(count != LandmarkTarget){
+            LandmarkTarget = count;
+            LandmarksValid = false;
         }
+    }
 
+    bool SetHeuristic(const std::vector<TLocation> &locations, THeuristic heuristic) noexcept{
+        if(locations.size() != vertices.size()){
+            return false;
+        }
+        try{
+            Locations = locations;
+        }
+        catch(...){
+            return false;
+        }
+        Heuristic = std::move(heuristic);
         return true;
     }
 
-    bool Precompute(std::chrono::steady_clock::time_point deadline) noexcept{//no precomp is needed for this way 
-        return true;
+    //A* search, same as dijkstra except the queue is ordered by distance so far plus the heuristic (and/or landmark bound) to dest
+    //the heuristic has to never overestimate (admissible) or the path it finds may not be the shortest
+    double FindShortestPathAStar(TVertexID src, TVertexID dest, std::vector<TVertexID> &path, SWorkspace &workspace){
+        path.clear();
+        if(src >= vertices.size() || dest >= vertices.size()){
+            return NoPathExists;
+        }
+        EnsureCompressedGraph();
+
+        auto &labels = workspace.Sides[0];
+        auto &priorityq = workspace.BinaryQueues[0];
+        labels.Reset(vertices.size());
+        priorityq.Reset(vertices.size());
+        const bool landmarks = Mode == ESearchMode::Landmarks && LandmarksValid;
+        //heuristic to dest, worked out the first time a vertex is reached
+        auto Estimate = [&](TVertexID v){
+            //both bounds are admissible so the larger one is too
+            double estimate = Heuristic && v < Locations.size() && dest < Locations.size() ? std::max(0.0, Heuristic(Locations[v], Locations[dest])) : 0.0;
+            if(landmarks){
+                estimate = std::max(estimate, LandmarkBound(v, dest));
+            }
+            return estimate;
+        };
+
+        labels.Label(src, 0, InvalidVertexID);
+        labels.estimate[src] = Estimate(src);
+        priorityq.Push(src, labels.estimate[src]);
+
+        while(!priorityq.Empty()){
+            auto [key, v] = priorityq.Pop();
+            if(v == dest){
+                break;
+            }
+            //stale entry, v was already reached more cheaply
+            if(key > labels.dist[v] + labels.estimate[v]){
+                continue;
+            }
+            for(std::size_t e = EdgeOffsets[v]; e < EdgeOffsets[v + 1]; e++){
+                TVertexID neighbor = EdgeTargets[e];
+                double newdist = labels.dist[v] + EdgeWeights[e];
+                if(!labels.Reached(neighbor)){
+                    labels.Label(neighbor, newdist, v);
+                    labels.estimate[neighbor] = Estimate(neighbor);
+                    priorityq.Push(neighbor, newdist + labels.estimate[neighbor]);
+                }
+                else if(newdist < labels.dist[neighbor]){
+                    labels.Label(neighbor, newdist, v);
+                    priorityq.Push(neighbor, newdist + labels.estimate[neighbor]);
+                }
+            }
+        }
+
+        if(!labels.Reached(dest)){
+            return NoPathExists;
+        }
+        for(TVertexID at = dest; at != src; at = labels.previous[at]){
+            path.push_back(at);
+        }
+        path.push_back(src);
+        std::reverse(path.begin(), path.end());
+        return labels.dist[dest];
+    }
+
+    //bidirectional dijkstra, one search forward from the sources on the CSR and one backward from the targets on the
+    //reverse CSR. it stops once the two smallest keys add up to at least the best path seen where the searches touched
+    double FindShortestPathBidirectional(const TSeeds &sources, const TSeeds &destinations, std::vector<TVertexID> &path, SWorkspace &workspace){
+        path.clear();
+        EnsureCompressedGraph();
+
+        //index 0 is the forward search from src, index 1 is the backward search from dest
+        auto &sides = workspace.Sides;
+        auto &priorityq = workspace.BinaryQueues;
+        const TGraphArray<std::size_t> *offsets[2] = {&EdgeOffsets, &ReverseOffsets};
+        const TGraphArray<TVertexID> *targets[2] = {&EdgeTargets, &ReverseSources};
+        const TGraphArray<double> *weights[2] = {&EdgeWeights, &ReverseWeights};
+        SeedSides(sources, destinations, sides, priorityq);
+        //a vertex that is both a source and a target is a path on its own
+        double best = NoPathExists;
+        TVertexID meet = InvalidVertexID;
+        for(auto &[vertex, distance] : sources){
+            if(vertex < vertices.size() && sides[1].Reached(vertex) && sides[0].dist[vertex] + sides[1].dist[vertex] < best){
+                best = sides[0].dist[vertex] + sides[1].dist[vertex];
+                meet = vertex;
+            }
+        }
+
+        while(!priorityq[0].Empty() && !priorityq[1].Empty()){
+            if(priorityq[0].Top().first + priorityq[1].Top().first >= best){
+                break;
+            }
+            //always grow the smaller frontier
+            int side = priorityq[0].Size() <= priorityq[1].Size() ? 0 : 1;
+            auto [distance, v] = priorityq[side].Pop();
+            if(distance > sides[side].Distance(v)){
+                continue;
+            }
+            for(std::size_t e = (*offsets[side])[v]; e < (*offsets[side])[v + 1]; e++){
+                TVertexID neighbor = (*targets[side])[e];
+                double newdist = distance + (*weights[side])[e];
+                if(newdist < sides[side].Distance(neighbor)){
+                    sides[side].Label(neighbor, newdist, v);
+                    priorityq[side].Push(neighbor, newdist);
+                }
+                if(sides[1 - side].Reached(neighbor) && sides[side].dist[neighbor] + sides[1 - side].dist[neighbor] < best){
+                    best = sides[side].dist[neighbor] + sides[1 - side].dist[neighbor];
+                    meet = neighbor;
+                }
+            }
+        }
+
+        if(meet == InvalidVertexID){
+            return NoPathExists;
+        }
+        for(TVertexID at = meet; at != InvalidVertexID; at = sides[0].previous[at]){
+            path.push_back(at);
+        }
+        std::reverse(path.begin(), path.end());
+        for(TVertexID at = sides[1].previous[meet]; at != InvalidVertexID; at = sides[1].previous[at]){
+            path.push_back(at);
+        }
+        return best;
     }
 
+    EQueuePolicy QueuePolicy = EQueuePolicy::QuaternaryHeap; //fastest of the three in routerbench on city.osm
+
     //now implement dijkstra to find shortest path // the std::vector will store the shortest path 
-    double FindShortestPath(TVertexID src, TVertexID dest, std::vector<TVertexID> &path) noexcept{
+    double FindShortestPathDijkstra(TVertexID src, TVertexID dest, std::vector<TVertexID> &path, SWorkspace &workspace) noexcept{
         // returns path distance of path from src to dest, and fills out path with vertices.
         //if no path, NoPathExists is returned.
 
@@ -107,30 +1436,39 @@ struct CDijkstraPathRouter::SImplementation{
             return NoPathExists;
         }
 
-        //now define a priority queue to store the vertices
-        //where elements is a pair of distance and vertex id
+        try{
+            //edges were added since the last Precompute so rebuild the CSR before searching
+            EnsureCompressedGraph();
+            switch(QueuePolicy){
+                case EQueuePolicy::QuaternaryHeap:  return DijkstraSearch(src, dest, path, workspace.QuaternaryHeap, workspace.Sides[0]);
+                case EQueuePolicy::RadixHeap:       return DijkstraSearch(src, dest, path, workspace.RadixHeap, workspace.Sides[0]);
+                default:                            return DijkstraSearch(src, dest, path, workspace.BinaryQueues[0], workspace.Sides[0]);
+            }
+        }
+        catch(...){
+            path.clear();
+            return NoPathExists;
+        }
+    }
 
+    template <typename TQueue> double DijkstraSearch(TVertexID src, TVertexID dest, std::vector<TVertexID> &path, TQueue &priorityq, SWorkspace::SSearchSide &labels){
+        //now empty the priority queue that stores the vertices
         //we will use priority queues because this should be more faster than a simple linear search of paths and our TC would
         //be O(V^2) 
-        std::priority_queue<std::pair<TVertexID, double>, std::vector<std::pair<TVertexID, double>>, std::greater<std::pair<TVertexID, double>>> priorityq;
+        priorityq.Reset(VertexCount());
 
-        //now we will define a distance vector to store the distance from src to each vertex 
-        //initializes distances to NoPathExists (infinite)
-        std::vector<double> dist(VertexCount(), NoPathExists);
-        //now we will define a previous vector to store the previous vertex in the path
-        std::vector<TVertexID> previous(VertexCount(), InvalidVertexID);
+        //the labels hold the distance from src and the previous vertex in the path for each vertex
+        //a vertex that isnt reached yet this query is at NoPathExists (infinite), resetting is O(1) not O(V)
+        labels.Reset(VertexCount());
 
         //now initialize src vertex distance to 0 and push it into priority queue 
-        priorityq.push(std::make_pair(0, src));
-        dist[src] = 0;
+        priorityq.Push(src, 0.0);
+        labels.Label(src, 0, InvalidVertexID);
 
         //now we will implement the dijkstra algorithm
-        while(!priorityq.empty()){
+        while(!priorityq.Empty()){
             //get the vertex with the smallest distance
-            TVertexID v = priorityq.top().second;
-            double distance = priorityq.top().first;
-
-            priorityq.pop();
+            auto [distance, v] = priorityq.Pop();
 
             //if we reach dest vertex you stop early 
             if(v == dest){
@@ -138,60 +1476,247 @@ struct CDijkstraPathRouter::SImplementation{
             }
 
             //now if current distance is bigger than the known one skip it
-            if(distance > dist[v]){
+            if(distance > labels.dist[v]){
                 continue;
             }
 
-            //now we will iterate over the neighbors of u
-            for(TVertexID neighbor : vertices[v]->GetNeighbors()){
-                double weight = vertices[v]->GetWeight(neighbor);
+            //now we will iterate over the neighbors of v, which are one contiguous slice of the CSR arrays
+            for(std::size_t e = EdgeOffsets[v]; e < EdgeOffsets[v + 1]; e++){
+                TVertexID neighbor = EdgeTargets[e];
+                double weight = EdgeWeights[e];
 
                 // now if new calcullation is better than the known one update it
-                if(dist[neighbor] > dist[v] + weight) {
-                    dist[neighbor] = dist[v] + weight;
-                    previous[neighbor] = v;
-                    priorityq.push(std::make_pair(dist[neighbor], neighbor));
+                if(labels.Distance(neighbor) > distance + weight) {
+                    labels.Label(neighbor, distance + weight, v);
+                    priorityq.Push(neighbor, distance + weight);
                 }
             }
         }
 
+        //if dest is still notpathexists no path is returned
+        if (!labels.Reached(dest)){
+            return NoPathExists;
+        }
+
         //nmwo you have to reconstruct the path
-        TVertexID at = dest;
-        while (at != src) {
+        for(TVertexID at = dest; at != src; at = labels.previous[at]){
             path.push_back(at);
-            if (previous[at] == InvalidVertexID) {
-                return NoPathExists;
-            }
-            at = previous[at];
         }
-
         path.push_back(src); // finish off reconstruction by adding src cuz we stopped right before in loop
 
         //now u reverese the path to make sure u have correct order from source to destination
         std::reverse(path.begin(), path.end());
 
         //this is the goaal now return total shortest path from dist to src to dest
-        //if dest is still notpathexists no path is returned
-        if (dist[dest] == NoPathExists){
-            return NoPathExists;
-        } else { 
-            return dist[dest];
+        return labels.dist[dest];
+    }
+
+    //one to many, one dijkstra from src that stops once every target is settled
+    bool FindDistances(TVertexID src, const std::vector<TVertexID> &targets, std::vector<double> &distances, SWorkspace &workspace) noexcept{
+        try{
+            distances.assign(targets.size(), NoPathExists);
+            if(src >= vertices.size()){
+                return true;
+            }
+            EnsureCompressedGraph();
+            switch(QueuePolicy){
+                case EQueuePolicy::QuaternaryHeap:  DijkstraToTargets(src, targets, distances, workspace.QuaternaryHeap, workspace); break;
+                case EQueuePolicy::RadixHeap:       DijkstraToTargets(src, targets, distances, workspace.RadixHeap, workspace); break;
+                default:                            DijkstraToTargets(src, targets, distances, workspace.BinaryQueues[0], workspace); break;
+            }
+            return true;
+        }
+        catch(...){
+            return false;
+        }
+    }
+
+    template <typename TQueue> void DijkstraToTargets(TVertexID src, const std::vector<TVertexID> &targets, std::vector<double> &distances, TQueue &priorityq, SWorkspace &workspace){
+        auto &labels = workspace.Sides[0];
+        //Sides[1] just marks the targets, previous is set to the target itself once it has been settled
+        auto &marks = workspace.Sides[1];
+        priorityq.Reset(VertexCount());
+        labels.Reset(VertexCount());
+        marks.Reset(VertexCount());
+        std::size_t remaining = 0;
+        for(TVertexID target : targets){
+            if(target < vertices.size() && !marks.Reached(target)){
+                marks.Label(target, 0, InvalidVertexID);
+                remaining++;
+            }
+        }
+
+        priorityq.Push(src, 0.0);
+        labels.Label(src, 0, InvalidVertexID);
+        while(remaining && !priorityq.Empty()){
+            auto [distance, v] = priorityq.Pop();
+            if(distance > labels.dist[v]){
+                continue;
+            }
+            if(marks.Reached(v) && marks.previous[v] != v){
+                marks.previous[v] = v;
+                remaining--;
+            }
+            for(std::size_t e = EdgeOffsets[v]; e < EdgeOffsets[v + 1]; e++){
+                TVertexID neighbor = EdgeTargets[e];
+                if(labels.Distance(neighbor) > distance + EdgeWeights[e]){
+                    labels.Label(neighbor, distance + EdgeWeights[e], v);
+                    priorityq.Push(neighbor, distance + EdgeWeights[e]);
+                }
+            }
+        }
+        //a target that wasnt settled is one the search never reached
+        for(std::size_t index = 0; index < targets.size(); index++){
+            if(targets[index] < vertices.size()){
+                distances[index] = labels.Distance(targets[index]);
+            }
+        }
+    }
+
+    //runs a full upward search on the hierarchy from start (side 0 forward on the up edges, side 1 backward on
+    //the down edges) and calls settle(v, distance) for every vertex it settles
+    template <typename TSettle> void SearchUpward(TVertexID start, int side, SWorkspace &workspace, TSettle settle){
+        const TGraphArray<std::size_t> &offsets = side == 0 ? UpOffsets : DownOffsets;
+        const TGraphArray<SHierarchyEdge> &edges = side == 0 ? UpEdges : DownEdges;
+        auto &labels = workspace.Sides[side];
+        auto &priorityq = workspace.BinaryQueues[side];
+        labels.Reset(vertices.size());
+        priorityq.Reset(vertices.size());
+        labels.Label(start, 0, InvalidVertexID);
+        priorityq.Push(start, 0.0);
+        while(!priorityq.Empty()){
+            auto [distance, v] = priorityq.Pop();
+            if(distance > labels.dist[v]){
+                continue;
+            }
+            settle(v, distance);
+            for(std::size_t e = offsets[v]; e < offsets[v + 1]; e++){
+                auto &edge = edges[e];
+                if(distance + edge.Weight < labels.Distance(edge.Target)){
+                    labels.Label(edge.Target, distance + edge.Weight, v, edge.Middle);
+                    priorityq.Push(edge.Target, distance + edge.Weight);
+                }
+            }
+        }
+    }
+
+    //many to many. with a hierarchy this is the bucket method: a backward upward search from every target leaves
+    //(target, distance) in a bucket at each vertex it settles, then a forward upward search from every source
+    //checks the bucket of each vertex it settles. any shortest path has a highest vertex both searches settle
+    //without a hierarchy it is one FindDistances per source
+    bool FindDistanceMatrix(const std::vector<TVertexID> &sources, const std::vector<TVertexID> &targets, std::vector<std::vector<double>> &matrix, SWorkspace &workspace) noexcept{
+        try{
+            matrix.assign(sources.size(), std::vector<double>(targets.size(), NoPathExists));
+            if(!(Mode == ESearchMode::ContractionHierarchies && HierarchyValid)){
+                for(std::size_t index = 0; index < sources.size(); index++){
+                    if(!FindDistances(sources[index], targets, matrix[index], workspace)){
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            //the buckets are laid out like the CSR, entries for vertex v are in BucketEntries[offsets[v] .. offsets[v + 1])
+            std::vector<std::tuple<TVertexID, std::size_t, double>> settled;
+            for(std::size_t index = 0; index < targets.size(); index++){
+                if(targets[index] < vertices.size()){
+                    SearchUpward(targets[index], 1, workspace, [&](TVertexID v, double distance){
+                        settled.push_back(std::make_tuple(v, index, distance));
+                    });
+                }
+            }
+            std::vector<std::size_t> offsets(vertices.size() + 1, 0);
+            for(auto &entry : settled){
+                offsets[std::get<0>(entry) + 1]++;
+            }
+            for(std::size_t v = 0; v < vertices.size(); v++){
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<std::pair<std::size_t, double>> buckets(settled.size());
+            std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+            for(auto &entry : settled){
+                buckets[fill[std::get<0>(entry)]++] = std::make_pair(std::get<1>(entry), std::get<2>(entry));
+            }
+
+            for(std::size_t index = 0; index < sources.size(); index++){
+                if(sources[index] >= vertices.size()){
+                    continue;
+                }
+                auto &row = matrix[index];
+                SearchUpward(sources[index], 0, workspace, [&](TVertexID v, double distance){
+                    for(std::size_t b = offsets[v]; b < offsets[v + 1]; b++){
+                        row[buckets[b].first] = std::min(row[buckets[b].first], distance + buckets[b].second);
+                    }
+                });
+            }
+            return true;
+        }
+        catch(...){
+            return false;
         }
     }
 
 };
-//now we will construct the dijkstra path router class
-CDijkstraPathRouter::CDijkstraPathRouter(){
+CDijkstraPathRouter::CQueryContext::CQueryContext(){
     DImplementation = std::make_unique<SImplementation>();
 }
 
+CDijkstraPathRouter::CQueryContext::~CQueryContext(){
+
+}
+
+//now we will construct the dijkstra path router class
+CDijkstraPathRouter::CDijkstraPathRouter(ESearchMode mode){
+    DImplementation = std::make_unique<SImplementation>(mode);
+}
+
+CDijkstraPathRouter::CDijkstraPathRouter(std::shared_ptr<const CMemoryMappedFile> snapshot, std::size_t offset, std::size_t size){
+    DImplementation = std::make_unique<SImplementation>(ESearchMode::Dijkstra);
+    if(snapshot && size == std::numeric_limits<std::size_t>::max()){
+        size = offset <= snapshot->Size() ? snapshot->Size() - offset : 0;
+    }
+    if(!DImplementation->Load(snapshot, offset, size)){
+        throw std::invalid_argument("Invalid or incompatible router snapshot");
+    }
+}
+
 CDijkstraPathRouter::~CDijkstraPathRouter(){
 
 }
+
+CDijkstraPathRouter::ESearchMode CDijkstraPathRouter::SearchMode() const noexcept{
+    return DImplementation->Mode;
+}
+
 std::size_t CDijkstraPathRouter::VertexCount() const noexcept{
     return DImplementation->VertexCount();
 }
 
+bool CDijkstraPathRouter::SetHeuristic(const std::vector<TLocation> &locations, THeuristic heuristic) noexcept{
+    return DImplementation->SetHeuristic(locations,std::move(heuristic));
+}
+
+void CDijkstraPathRouter::SetQueuePolicy(EQueuePolicy policy) noexcept{
+    DImplementation->QueuePolicy = policy;
+}
+
+CDijkstraPathRouter::EQueuePolicy CDijkstraPathRouter::QueuePolicy() const noexcept{
+    return DImplementation->QueuePolicy;
+}
+
+void CDijkstraPathRouter::SetLandmarkCount(std::size_t count) noexcept{
+    DImplementation->SetLandmarkCount(count);
+}
+
+std::size_t CDijkstraPathRouter::LandmarkCount() const noexcept{
+    return DImplementation->Landmarks.size();
+}
+
+std::size_t CDijkstraPathRouter::BytesPerLandmark() const noexcept{
+    //one distance from and one distance to the landmark for every vertex
+    return 2 * DImplementation->VertexCount() * sizeof(double);
+}
+
 CPathRouter::TVertexID CDijkstraPathRouter::AddVertex(std::any tag) noexcept{
     return DImplementation->AddVertex(tag);
 }
@@ -204,10 +1729,34 @@ bool CDijkstraPathRouter::AddEdge(TVertexID src, TVertexID dest, double weight,
     return DImplementation->AddEdge(src,dest,weight,bidir);
 }
 
+bool CDijkstraPathRouter::Save(std::shared_ptr<CDataSink> sink) const noexcept{
+    return DImplementation->Save(sink);
+}
+
+bool CDijkstraPathRouter::Load(std::shared_ptr<CDataSource> source) noexcept{
+    return DImplementation->Load(source);
+}
+
 bool CDijkstraPathRouter::Precompute(std::chrono::steady_clock::time_point deadline) noexcept{
     return DImplementation->Precompute(deadline);
 }
 
 double CDijkstraPathRouter::FindShortestPath(TVertexID src, TVertexID dest, std::vector<TVertexID> &path) noexcept{
-    return DImplementation->FindShortestPath(src,dest,path);
+    return DImplementation->FindShortestPath(src,dest,path,*DImplementation->DefaultContext.DImplementation);
+}
+
+double CDijkstraPathRouter::FindShortestPath(TVertexID src, TVertexID dest, std::vector<TVertexID> &path, CQueryContext &context) const noexcept{
+    return DImplementation->FindShortestPath(src,dest,path,*context.DImplementation);
+}
+
+double CDijkstraPathRouter::FindShortestPath(const TSeeds &sources, const TSeeds &targets, std::vector<TVertexID> &path, CQueryContext &context) const noexcept{
+    return DImplementation->FindShortestPath(sources,targets,path,*context.DImplementation);
+}
+
+bool CDijkstraPathRouter::FindDistances(TVertexID src, const std::vector<TVertexID> &targets, std::vector<double> &distances, CQueryContext &context) const noexcept{
+    return DImplementation->FindDistances(src,targets,distances,*context.DImplementation);
+}
+
+bool CDijkstraPathRouter::FindDistanceMatrix(const std::vector<TVertexID> &sources, const std::vector<TVertexID> &targets, std::vector<std::vector<double>> &matrix, CQueryContext &context) const noexcept{
+    return DImplementation->FindDistanceMatrix(sources,targets,matrix,*context.DImplementation);
 }
\ No newline at end of file
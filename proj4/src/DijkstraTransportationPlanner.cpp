@@ -2,36 +2,515 @@
 #include "DijkstraTransportationPlanner.h"
 #include "DijkstraPathRouter.h"
 #include "GeographicUtils.h"
+#include "BinarySnapshot.h"
+#include "MemoryMappedFile.h"
+#include "StringDataSource.h"
+#include "StringDataSink.h"
 #include <queue>
 #include <unordered_map>
 #include <set>
+#include <tuple>
 #include <cmath>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <exception>
+#include <new>
+#include <stdexcept>
 
 struct CDijkstraTransportationPlanner::SImplementation
 {
-    
+    //one of the routing graphs with its degree 2 chains contracted. most nodes are shape points part way along a
+    //street whose only neighbours are the node before and the node after, so only the other nodes (junctions) are
+    //router vertices and each chain of shape points between two junctions is one router edge with the summed
+    //weight. the chains keep their nodes and step weights, so a path is unpacked back to every node and a query
+    //can start or end part way along one
+    struct SCompactGraph
+    {
+        //Nodes runs from a junction to a junction (the same one for a loop) through nodes only this chain has
+        //Forward[i] is the weight of Nodes[i] -> Nodes[i + 1] and Backward[i] of Nodes[i + 1] -> Nodes[i],
+        //Backward is empty if the chain is one way
+        struct SChain
+        {
+            std::vector<CStreetMap::TNodeID> Nodes;
+            std::vector<double> Forward;
+            std::vector<double> Backward;
+        };
+
+        //a router edge that stands for a chain, run from the back to the front if Forward is false
+        struct SChainEdge
+        {
+            CPathRouter::TVertexID Target;
+            std::size_t Chain;
+            bool Forward;
+        };
+
+        std::shared_ptr<CDijkstraPathRouter> Router;
+        std::unordered_map<CStreetMap::TNodeID, CPathRouter::TVertexID> NodeIDToVertexID; //junctions only
+        std::vector<CStreetMap::TNodeID> VertexIDToNodeID;
+        std::vector<SChain> Chains;
+        std::unordered_map<CStreetMap::TNodeID, std::pair<std::size_t, std::size_t>> ChainPositions; //the other nodes, chain and index in its Nodes
+        std::vector<std::vector<SChainEdge>> ChainEdges; //by source vertex, plain edges arent in here
+        std::vector<std::tuple<std::size_t, std::size_t, double>> Edges; //by sorted node index, only until Build
+
+        //like the router's AddEdge a later weight for the same pair replaces the earlier one
+        void AddEdge(std::size_t src, std::size_t dest, double weight)
+        {
+            Edges.emplace_back(src, dest, weight);
+        }
+
+        //the weight of going along chain from Nodes[from] to Nodes[to], NoPathExists if that is against a one way
+        static double Along(const SChain &chain, std::size_t from, std::size_t to)
+        {
+            double weight = 0;
+            if (from <= to)
+            {
+                for (std::size_t index = from; index < to; index++)
+                    weight += chain.Forward[index];
+                return weight;
+            }
+            if (chain.Backward.empty())
+                return CPathRouter::NoPathExists;
+            for (std::size_t index = from; index > to; index--)
+                weight += chain.Backward[index - 1];
+            return weight;
+        }
+
+        //appends Nodes[from] (not included) to Nodes[to] to path
+        static void AppendAlong(const SChain &chain, std::size_t from, std::size_t to, std::vector<CStreetMap::TNodeID> &path)
+        {
+            for (std::size_t index = from; index < to; index++)
+                path.push_back(chain.Nodes[index + 1]);
+            for (std::size_t index = from; index > to; index--)
+                path.push_back(chain.Nodes[index - 1]);
+        }
+
+        //builds the router from the edges added, nodes is every node id in sorted order
+        void Build(const std::vector<CStreetMap::TNodeID> &nodes, CDijkstraPathRouter::ESearchMode mode)
+        {
+            const std::size_t count = nodes.size();
+            //keep the last weight of every pair, a loop from a node to itself is never on a shortest path
+            std::stable_sort(Edges.begin(), Edges.end(), [](auto &a, auto &b)
+                             { return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) < std::get<0>(b) : std::get<1>(a) < std::get<1>(b); });
+            std::vector<std::vector<std::pair<std::size_t, double>>> out(count), in(count);
+            for (std::size_t index = 0; index < Edges.size(); index++)
+            {
+                auto [src, dest, weight] = Edges[index];
+                if (src == dest || (index + 1 < Edges.size() && std::get<0>(Edges[index + 1]) == src && std::get<1>(Edges[index + 1]) == dest))
+                    continue;
+                out[src].emplace_back(dest, weight);
+                in[dest].emplace_back(src, weight);
+            }
+            Edges.clear();
+            Edges.shrink_to_fit();
+
+            //a node goes in a chain if it has two neighbours and either goes both ways to both of them or comes from
+            //one and goes to the other. the nodes next to a two way one are two way too, so a chain is all one or the other
+            std::vector<char> chained(count, 0), visited(count, 0);
+            for (std::size_t node = 0; node < count; node++)
+            {
+                auto &outs = out[node], &ins = in[node];
+                if (outs.size() == 1 && ins.size() == 1)
+                    chained[node] = outs[0].first != ins[0].first;
+                else if (outs.size() == 2 && ins.size() == 2)
+                    chained[node] = (outs[0].first == ins[0].first && outs[1].first == ins[1].first) || (outs[0].first == ins[1].first && outs[1].first == ins[0].first);
+            }
+            auto weightOf = [&out](std::size_t src, std::size_t dest)
+            {
+                for (auto &[target, weight] : out[src])
+                    if (target == dest)
+                        return weight;
+                return CPathRouter::NoPathExists;
+            };
+
+            //follows the chain from junction start through next to the junction at its other end
+            std::vector<std::pair<std::size_t, std::size_t>> ends;
+            auto walk = [&](std::size_t start, std::size_t next)
+            {
+                SChain chain;
+                const bool twoway = out[next].size() == 2;
+                chain.Nodes.push_back(nodes[start]);
+                std::size_t previous = start, at = next;
+                while (true)
+                {
+                    chain.Forward.push_back(weightOf(previous, at));
+                    if (twoway)
+                        chain.Backward.push_back(weightOf(at, previous));
+                    chain.Nodes.push_back(nodes[at]);
+                    if (!chained[at])
+                        break;
+                    visited[at] = 1;
+                    ChainPositions[nodes[at]] = {Chains.size(), chain.Nodes.size() - 1};
+                    std::size_t following = out[at][0].first != previous ? out[at][0].first : out[at][1].first;
+                    previous = at;
+                    at = following;
+                }
+                Chains.push_back(std::move(chain));
+                ends.emplace_back(start, at);
+            };
+            for (std::size_t node = 0; node < count; node++)
+            {
+                if (!chained[node])
+                {
+                    for (auto &[next, weight] : out[node])
+                        if (chained[next] && !visited[next])
+                            walk(node, next);
+                }
+            }
+            //what is left are loops with no junction on them, the first node of each becomes one
+            for (std::size_t node = 0; node < count; node++)
+            {
+                if (chained[node] && !visited[node])
+                {
+                    chained[node] = 0;
+                    for (auto &[next, weight] : out[node])
+                        if (chained[next] && !visited[next])
+                            walk(node, next);
+                }
+            }
+
+            Router = std::make_shared<CDijkstraPathRouter>(mode);
+            std::vector<CPathRouter::TVertexID> vertices(count, CPathRouter::InvalidVertexID);
+            for (std::size_t node = 0; node < count; node++)
+            {
+                if (!chained[node])
+                {
+                    vertices[node] = Router->AddVertex(nodes[node]);
+                    NodeIDToVertexID[nodes[node]] = vertices[node];
+                    VertexIDToNodeID.push_back(nodes[node]);
+                }
+            }
+
+            //the edges between junctions and each chain both ways, where more than one runs between the same two
+            //junctions only the shortest goes in the router. a chain back to its own junction isnt an edge at all
+            const std::size_t plain = Chains.size();
+            std::vector<std::tuple<CPathRouter::TVertexID, CPathRouter::TVertexID, double, std::size_t, bool>> candidates;
+            for (std::size_t node = 0; node < count; node++)
+            {
+                if (!chained[node])
+                {
+                    for (auto &[dest, weight] : out[node])
+                        if (!chained[dest])
+                            candidates.emplace_back(vertices[node], vertices[dest], weight, plain, true);
+                }
+            }
+            for (std::size_t chain = 0; chain < Chains.size(); chain++)
+            {
+                auto [start, end] = ends[chain];
+                if (start == end)
+                    continue;
+                const std::size_t last = Chains[chain].Nodes.size() - 1;
+                candidates.emplace_back(vertices[start], vertices[end], Along(Chains[chain], 0, last), chain, true);
+                if (!Chains[chain].Backward.empty())
+                    candidates.emplace_back(vertices[end], vertices[start], Along(Chains[chain], last, 0), chain, false);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(), [](auto &a, auto &b)
+                             { return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) < std::get<0>(b) : std::get<1>(a) < std::get<1>(b); });
+            ChainEdges.assign(VertexIDToNodeID.size(), {});
+            for (std::size_t index = 0; index < candidates.size();)
+            {
+                std::size_t best = index;
+                for (index++; index < candidates.size() && std::get<0>(candidates[index]) == std::get<0>(candidates[best]) && std::get<1>(candidates[index]) == std::get<1>(candidates[best]); index++)
+                {
+                    if (std::get<2>(candidates[index]) < std::get<2>(candidates[best]))
+                        best = index;
+                }
+                auto [src, dest, weight, chain, forward] = candidates[best];
+                Router->AddEdge(src, dest, weight);
+                if (chain != plain)
+                    ChainEdges[src].push_back({dest, chain, forward});
+            }
+        }
+
+        //the vertices a query starting at node can leave from (or one ending at node arrive through) and the weight
+        //along its chain to (or from) them, positions gets the index in the chain's Nodes of each one
+        //false if the graph doesnt have the node
+        bool Seeds(CStreetMap::TNodeID node, bool arriving, CDijkstraPathRouter::TSeeds &seeds, std::vector<std::size_t> &positions) const
+        {
+            seeds.clear();
+            positions.clear();
+            auto vertex = NodeIDToVertexID.find(node);
+            if (vertex != NodeIDToVertexID.end())
+            {
+                seeds.emplace_back(vertex->second, 0.0);
+                positions.push_back(0);
+                return true;
+            }
+            auto position = ChainPositions.find(node);
+            if (position == ChainPositions.end())
+                return false;
+            auto &chain = Chains[position->second.first];
+            const std::size_t at = position->second.second, last = chain.Nodes.size() - 1;
+            for (std::size_t end : {last, std::size_t(0)})
+            {
+                double weight = arriving ? Along(chain, end, at) : Along(chain, at, end);
+                if (weight != CPathRouter::NoPathExists)
+                {
+                    seeds.emplace_back(NodeIDToVertexID.at(chain.Nodes[end]), weight);
+                    positions.push_back(end);
+                }
+            }
+            return true;
+        }
+
+        //which seed a router path that starts or ends at vertex used, the router keeps the first of the smallest
+        static std::size_t UsedSeed(const CDijkstraPathRouter::TSeeds &seeds, CPathRouter::TVertexID vertex)
+        {
+            std::size_t used = seeds.size();
+            for (std::size_t index = 0; index < seeds.size(); index++)
+            {
+                if (seeds[index].first == vertex && (used == seeds.size() || seeds[index].second < seeds[used].second))
+                    used = index;
+            }
+            return used;
+        }
+
+        //the weight straight along the chain if src and dest are both part way along the same one
+        double SameChain(CStreetMap::TNodeID src, CStreetMap::TNodeID dest) const
+        {
+            auto srcPosition = ChainPositions.find(src), destPosition = ChainPositions.find(dest);
+            if (srcPosition == ChainPositions.end() || destPosition == ChainPositions.end() || srcPosition->second.first != destPosition->second.first)
+                return CPathRouter::NoPathExists;
+            return Along(Chains[srcPosition->second.first], srcPosition->second.second, destPosition->second.second);
+        }
+
+        double FindPath(CStreetMap::TNodeID src, CStreetMap::TNodeID dest, std::vector<CStreetMap::TNodeID> &path) const
+        {
+            path.clear();
+            CDijkstraPathRouter::TSeeds sources, targets;
+            std::vector<std::size_t> exits, entries;
+            if (!Seeds(src, false, sources, exits) || !Seeds(dest, true, targets, entries))
+                return CPathRouter::NoPathExists;
+            std::vector<CPathRouter::TVertexID> routerPath;
+            double distance = Router->FindShortestPath(sources, targets, routerPath, QueryContext());
+
+            path.push_back(src);
+            double direct = SameChain(src, dest);
+            if (direct != CPathRouter::NoPathExists && direct <= distance)
+            {
+                AppendAlong(Chains[ChainPositions.at(src).first], ChainPositions.at(src).second, ChainPositions.at(dest).second, path);
+                return direct;
+            }
+            if (distance == CPathRouter::NoPathExists)
+            {
+                path.clear();
+                return CPathRouter::NoPathExists;
+            }
+            //out to the first vertex, along the router path unpacking the chain edges, and in from the last one
+            auto srcPosition = ChainPositions.find(src);
+            if (srcPosition != ChainPositions.end())
+                AppendAlong(Chains[srcPosition->second.first], srcPosition->second.second, exits[UsedSeed(sources, routerPath.front())], path);
+            for (std::size_t index = 1; index < routerPath.size(); index++)
+            {
+                auto &edges = ChainEdges[routerPath[index - 1]];
+                auto edge = std::find_if(edges.begin(), edges.end(), [&](const SChainEdge &edge)
+                                         { return edge.Target == routerPath[index]; });
+                if (edge == edges.end())
+                {
+                    path.push_back(VertexIDToNodeID[routerPath[index]]);
+                    continue;
+                }
+                auto &chain = Chains[edge->Chain];
+                const std::size_t last = chain.Nodes.size() - 1;
+                AppendAlong(chain, edge->Forward ? 0 : last, edge->Forward ? last : 0, path);
+            }
+            auto destPosition = ChainPositions.find(dest);
+            if (destPosition != ChainPositions.end())
+                AppendAlong(Chains[destPosition->second.first], entries[UsedSeed(targets, routerPath.back())], destPosition->second.second, path);
+            return distance;
+        }
+
+        //table[i][j] is the weight from srcs[i] to dests[j]. the router table is run between the seed vertices of
+        //all of them, every pair then takes its best seeds. the one to many table runs a single search per source
+        //vertex instead of the matrix buckets, like the router's own FindDistances
+        std::vector<std::vector<double>> Table(const std::vector<CStreetMap::TNodeID> &srcs, const std::vector<CStreetMap::TNodeID> &dests, bool onetomany) const
+        {
+            //per node its seeds as (index in the vertex list, weight) and its chain position for the straight along check
+            struct SEnd
+            {
+                std::vector<std::pair<std::size_t, double>> Seeds;
+                const std::pair<std::size_t, std::size_t> *Position = nullptr;
+            };
+            CDijkstraPathRouter::TSeeds seeds;
+            std::vector<std::size_t> positions;
+            auto collect = [&](const std::vector<CStreetMap::TNodeID> &ids, bool arriving, std::vector<CPathRouter::TVertexID> &vertices)
+            {
+                std::vector<SEnd> ends(ids.size());
+                std::unordered_map<CPathRouter::TVertexID, std::size_t> indices;
+                for (std::size_t index = 0; index < ids.size(); index++)
+                {
+                    Seeds(ids[index], arriving, seeds, positions);
+                    for (auto &[vertex, weight] : seeds)
+                    {
+                        auto inserted = indices.emplace(vertex, vertices.size());
+                        if (inserted.second)
+                            vertices.push_back(vertex);
+                        ends[index].Seeds.emplace_back(inserted.first->second, weight);
+                    }
+                    auto position = ChainPositions.find(ids[index]);
+                    if (position != ChainPositions.end())
+                        ends[index].Position = &position->second;
+                }
+                return ends;
+            };
+            std::vector<CPathRouter::TVertexID> sourceVertices, targetVertices;
+            auto sources = collect(srcs, false, sourceVertices);
+            auto targets = collect(dests, true, targetVertices);
+
+            //the router just returns false if anything went wrong, which only running out of memory can do
+            std::vector<std::vector<double>> vertexTable;
+            if (onetomany)
+            {
+                vertexTable.resize(sourceVertices.size());
+                for (std::size_t index = 0; index < sourceVertices.size(); index++)
+                {
+                    if (!Router->FindDistances(sourceVertices[index], targetVertices, vertexTable[index], QueryContext()))
+                        throw std::bad_alloc();
+                }
+            }
+            else if (!Router->FindDistanceMatrix(sourceVertices, targetVertices, vertexTable, QueryContext()))
+                throw std::bad_alloc();
+
+            std::vector<std::vector<double>> table(srcs.size(), std::vector<double>(dests.size(), CPathRouter::NoPathExists));
+            for (std::size_t row = 0; row < srcs.size(); row++)
+            {
+                for (std::size_t col = 0; col < dests.size(); col++)
+                {
+                    double &best = table[row][col];
+                    for (auto &[source, sourceWeight] : sources[row].Seeds)
+                    {
+                        for (auto &[target, targetWeight] : targets[col].Seeds)
+                        {
+                            double weight = vertexTable[source][target];
+                            if (weight != CPathRouter::NoPathExists)
+                                best = std::min(best, sourceWeight + weight + targetWeight);
+                        }
+                    }
+                    auto srcPosition = sources[row].Position, destPosition = targets[col].Position;
+                    if (srcPosition && destPosition && srcPosition->first == destPosition->first)
+                        best = std::min(best, Along(Chains[srcPosition->first], srcPosition->second, destPosition->second));
+                }
+            }
+            return table;
+        }
+
+        void Save(CSnapshotWriter &writer) const
+        {
+            std::vector<uint64_t> chainOffsets = {0};
+            std::vector<CStreetMap::TNodeID> chainNodes;
+            std::vector<double> forward, backward;
+            std::vector<uint8_t> twoway;
+            for (auto &chain : Chains)
+            {
+                chainNodes.insert(chainNodes.end(), chain.Nodes.begin(), chain.Nodes.end());
+                forward.insert(forward.end(), chain.Forward.begin(), chain.Forward.end());
+                backward.insert(backward.end(), chain.Backward.begin(), chain.Backward.end());
+                chainOffsets.push_back(chainNodes.size());
+                twoway.push_back(!chain.Backward.empty());
+            }
+            std::vector<CPathRouter::TVertexID> edgeSources, edgeTargets;
+            std::vector<uint64_t> edgeChains;
+            std::vector<uint8_t> edgeForward;
+            for (std::size_t vertex = 0; vertex < ChainEdges.size(); vertex++)
+            {
+                for (auto &edge : ChainEdges[vertex])
+                {
+                    edgeSources.push_back(vertex);
+                    edgeTargets.push_back(edge.Target);
+                    edgeChains.push_back(edge.Chain);
+                    edgeForward.push_back(edge.Forward);
+                }
+            }
+            writer.WriteVector(VertexIDToNodeID);
+            writer.WriteVector(chainOffsets);
+            writer.WriteVector(chainNodes);
+            writer.WriteVector(twoway);
+            writer.WriteVector(forward);
+            writer.WriteVector(backward);
+            writer.WriteVector(edgeSources);
+            writer.WriteVector(edgeTargets);
+            writer.WriteVector(edgeChains);
+            writer.WriteVector(edgeForward);
+            WriteRouter(writer, *Router);
+        }
+
+        bool Load(CSnapshotReader &reader, const std::shared_ptr<const CMemoryMappedFile> &mapping)
+        {
+            std::vector<uint64_t> chainOffsets, edgeChains;
+            std::vector<CStreetMap::TNodeID> chainNodes;
+            std::vector<double> forward, backward;
+            std::vector<uint8_t> twoway, edgeForward;
+            std::vector<CPathRouter::TVertexID> edgeSources, edgeTargets;
+            if (!reader.ReadVector(VertexIDToNodeID) || !reader.ReadVector(chainOffsets) || !reader.ReadVector(chainNodes) || !reader.ReadVector(twoway) || !reader.ReadVector(forward) || !reader.ReadVector(backward))
+                return false;
+            if (!reader.ReadVector(edgeSources) || !reader.ReadVector(edgeTargets) || !reader.ReadVector(edgeChains) || !reader.ReadVector(edgeForward) || !ReadRouter(reader, Router, mapping))
+                return false;
+            if (VertexIDToNodeID.size() != Router->VertexCount() || chainOffsets.empty() || chainOffsets[0] != 0 || chainOffsets.back() != chainNodes.size() || twoway.size() + 1 != chainOffsets.size())
+                return false;
+            for (CPathRouter::TVertexID vertex = 0; vertex < VertexIDToNodeID.size(); vertex++)
+                NodeIDToVertexID[VertexIDToNodeID[vertex]] = vertex;
+
+            //every chain is at least one step between two junctions, with its weights taken in order
+            std::size_t forwardUsed = 0, backwardUsed = 0;
+            for (std::size_t index = 0; index < twoway.size(); index++)
+            {
+                if (chainOffsets[index + 1] < chainOffsets[index] + 2)
+                    return false;
+                SChain chain;
+                chain.Nodes.assign(chainNodes.begin() + chainOffsets[index], chainNodes.begin() + chainOffsets[index + 1]);
+                const std::size_t steps = chain.Nodes.size() - 1;
+                if (forward.size() - forwardUsed < steps || (twoway[index] && backward.size() - backwardUsed < steps))
+                    return false;
+                chain.Forward.assign(forward.begin() + forwardUsed, forward.begin() + forwardUsed + steps);
+                forwardUsed += steps;
+                if (twoway[index])
+                {
+                    chain.Backward.assign(backward.begin() + backwardUsed, backward.begin() + backwardUsed + steps);
+                    backwardUsed += steps;
+                }
+                if (!NodeIDToVertexID.count(chain.Nodes.front()) || !NodeIDToVertexID.count(chain.Nodes.back()))
+                    return false;
+                for (std::size_t position = 1; position < steps; position++)
+                    ChainPositions[chain.Nodes[position]] = {Chains.size(), position};
+                Chains.push_back(std::move(chain));
+            }
+            if (forwardUsed != forward.size() || backwardUsed != backward.size())
+                return false;
+
+            const std::size_t count = edgeSources.size();
+            if (edgeTargets.size() != count || edgeChains.size() != count || edgeForward.size() != count)
+                return false;
+            ChainEdges.assign(VertexIDToNodeID.size(), {});
+            for (std::size_t index = 0; index < count; index++)
+            {
+                if (edgeSources[index] >= ChainEdges.size() || edgeTargets[index] >= ChainEdges.size() || edgeChains[index] >= Chains.size())
+                    return false;
+                ChainEdges[edgeSources[index]].push_back({edgeTargets[index], edgeChains[index], edgeForward[index] != 0});
+            }
+            return true;
+        }
+    };
+
     std::shared_ptr<SConfiguration> Config;
     //this is the config data that contain the streetmap, bus systems, and speed
     std::vector<std::shared_ptr<CStreetMap::SNode>> SortedNodes;
     //nodes arranged by id
-    std::shared_ptr<CDijkstraPathRouter> DistanceRouter;
-    //this is path routers for dist and time
-    std::shared_ptr<CDijkstraPathRouter> TimeRouter;
-     //this is path routers for dist and time
-
-    std::unordered_map<CStreetMap::TNodeID, CPathRouter::TVertexID> NodeIDToDistanceVertexID;
-    std::unordered_map<CStreetMap::TNodeID, CPathRouter::TVertexID> NodeIDToTimeVertexID;
-    std::unordered_map<CPathRouter::TVertexID, CStreetMap::TNodeID> DistanceVertexIDToNodeID;
-    std::unordered_map<CPathRouter::TVertexID, CStreetMap::TNodeID> TimeVertexIDToNodeID;
-    //these are mappings between street map node id and router vertex id
+    SCompactGraph DistanceGraph;
+    SCompactGraph TimeGraph;
+    //the graphs and path routers for dist and time
 
 
     std::unordered_map<CStreetMap::TNodeID, size_t> NodeIDToIndex;
     //this looks up node position in sorted node list or vector
 
+    double MaxSpeed = 0.0;
+    //fastest speed of any time edge, so straight line distance / MaxSpeed never overestimates a travel time
+
 
 //the ones belwo are for the bus system
     std::unordered_map<CBusSystem::TStopID, CStreetMap::TNodeID> StopIDToNodeID;//this maps stop id to node id
@@ -43,11 +522,255 @@ struct CDijkstraTransportationPlanner::SImplementation
     //constructor initliazes the ds and goes through the map data
     SImplementation(std::shared_ptr<SConfiguration> config) : Config(config)
     {
+        //the precompute time budget covers the whole construction, not just the router precompute
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(Config->PrecomputeTime());
         InitializeNodes(); // sorts/indexes nodes
-        CreateRouterVertices();//sets up routes
         ProcessBusSystem();//bus stop datas
         ProcessAllWays();//loads road infos
         AddBusEdges(); //this adds bus routes onto the graph
+        BuildGraphs(); //contracts the chains and sets up the routers
+        SetRouterHeuristics(); //straight line lower bounds for A*
+        DistanceGraph.Router->Precompute(deadline); //this builds the compact graphs the queries search
+        TimeGraph.Router->Precompute(deadline);
+    }
+
+    //restores everything the constructor above builds from a snapshot Save wrote, no street map or bus system needed
+    SImplementation(std::shared_ptr<SConfiguration> config, std::shared_ptr<CDataSource> snapshot) : Config(config)
+    {
+        CSnapshotReader reader;
+        if (!reader.Start(snapshot, SnapshotMagic, SnapshotVersion) || !LoadSnapshot(reader, nullptr))
+            throw std::invalid_argument("Invalid or incompatible planner snapshot");
+        SetRouterHeuristics();
+    }
+
+    //same as above but reads the snapshot in place, the routers' graph arrays point straight into the mapped file
+    SImplementation(std::shared_ptr<SConfiguration> config, std::shared_ptr<const CMemoryMappedFile> snapshot) : Config(config)
+    {
+        CSnapshotReader reader;
+        if (!snapshot || !snapshot->Valid() || !reader.Start(snapshot->Data(), snapshot->Size(), SnapshotMagic, SnapshotVersion) || !LoadSnapshot(reader, snapshot))
+            throw std::invalid_argument("Invalid or incompatible planner snapshot");
+        SetRouterHeuristics();
+    }
+
+    //a node restored from a snapshot, the planner only needs the id and location but keeps the tags so
+    //SortedNodeByIndex gives back the same thing either way
+    struct SSnapshotNode : public CStreetMap::SNode
+    {
+        TNodeID Identifier;
+        CStreetMap::TLocation NodeLocation;
+        std::vector<std::pair<std::string, std::string>> Tags;
+
+        TNodeID ID() const noexcept override { return Identifier; }
+        CStreetMap::TLocation Location() const noexcept override { return NodeLocation; }
+        std::size_t AttributeCount() const noexcept override { return Tags.size(); }
+        std::string GetAttributeKey(std::size_t index) const noexcept override
+        {
+            return index < Tags.size() ? Tags[index].first : "";
+        }
+        bool HasAttribute(const std::string &key) const noexcept override
+        {
+            return std::any_of(Tags.begin(), Tags.end(), [&key](auto &tag) { return tag.first == key; });
+        }
+        std::string GetAttribute(const std::string &key) const noexcept override
+        {
+            for (auto &tag : Tags)
+                if (tag.first == key)
+                    return tag.second;
+            return "";
+        }
+    };
+
+    static constexpr char SnapshotMagic[8] = {'C', 'D', 'T', 'P', 'S', 'N', 'A', 'P'};
+    static constexpr uint32_t SnapshotVersion = 3;
+
+    //the graph weights depend on these so a snapshot only goes with a config that has the same ones
+    void WriteConfig(CSnapshotWriter &writer) const
+    {
+        writer.Write(Config->WalkSpeed());
+        writer.Write(Config->BikeSpeed());
+        writer.Write(Config->DefaultSpeedLimit());
+        writer.Write(Config->BusStopTime());
+    }
+
+    static void WriteRouter(CSnapshotWriter &writer, const CDijkstraPathRouter &router)
+    {
+        auto sink = std::make_shared<CStringDataSink>();
+        if (!router.Save(sink))
+            throw std::bad_alloc();
+        //written as an array so the router snapshot starts 8 byte aligned and can be read in place
+        const std::string &bytes = sink->String();
+        writer.WriteArray(bytes.data(), bytes.size());
+    }
+
+    static bool ReadRouter(CSnapshotReader &reader, std::shared_ptr<CDijkstraPathRouter> &router, const std::shared_ptr<const CMemoryMappedFile> &mapping)
+    {
+        const char *bytes;
+        std::size_t size;
+        if (!reader.ReadArray(bytes, size))
+            return false;
+        if (mapping)
+        {
+            try
+            {
+                router = std::make_shared<CDijkstraPathRouter>(mapping, bytes - mapping->Data(), size);
+                return true;
+            }
+            catch (const std::invalid_argument &)
+            {
+                return false;
+            }
+        }
+        router = std::make_shared<CDijkstraPathRouter>();
+        return router->Load(std::make_shared<CStringDataSource>(std::string(bytes, size)));
+    }
+
+    bool SaveSnapshot(std::shared_ptr<CDataSink> sink) const
+    {
+        CSnapshotWriter writer;
+        WriteConfig(writer);
+        writer.Write(MaxSpeed);
+
+        //sorted nodes, in sorted order
+        std::vector<CStreetMap::TNodeID> ids;
+        std::vector<double> latitudes, longitudes;
+        std::vector<uint64_t> tagOffsets = {0};
+        for (auto &node : SortedNodes)
+        {
+            ids.push_back(node->ID());
+            latitudes.push_back(node->Location().first);
+            longitudes.push_back(node->Location().second);
+            tagOffsets.push_back(tagOffsets.back() + node->AttributeCount());
+        }
+        writer.WriteVector(ids);
+        writer.WriteVector(latitudes);
+        writer.WriteVector(longitudes);
+        writer.WriteVector(tagOffsets);
+        for (auto &node : SortedNodes)
+        {
+            for (std::size_t index = 0; index < node->AttributeCount(); index++)
+            {
+                auto key = node->GetAttributeKey(index);
+                writer.WriteString(key);
+                writer.WriteString(node->GetAttribute(key));
+            }
+        }
+
+        //bus stops and the route metadata FindFastestPath uses to label bus steps
+        std::vector<CBusSystem::TStopID> stopIDs, nodeStopIDs;
+        std::vector<CStreetMap::TNodeID> stopNodeIDs, nodeIDs;
+        for (auto &[stopID, nodeID] : StopIDToNodeID)
+        {
+            stopIDs.push_back(stopID);
+            stopNodeIDs.push_back(nodeID);
+        }
+        for (auto &[nodeID, stopID] : NodeIDToStopID)
+        {
+            nodeIDs.push_back(nodeID);
+            nodeStopIDs.push_back(stopID);
+        }
+        writer.WriteVector(stopIDs);
+        writer.WriteVector(stopNodeIDs);
+        writer.WriteVector(nodeIDs);
+        writer.WriteVector(nodeStopIDs);
+        writer.Write<uint64_t>(BusRouteInfo.size());
+        for (auto &[nodeID, routes] : BusRouteInfo)
+        {
+            writer.Write(nodeID);
+            writer.Write<uint64_t>(routes.size());
+            for (auto &[routeName, nextNodeID] : routes)
+            {
+                writer.WriteString(routeName);
+                writer.Write(nextNodeID);
+            }
+        }
+
+        //each graph's vertices and chains and then its router
+        DistanceGraph.Save(writer);
+        TimeGraph.Save(writer);
+        return writer.Finish(sink, SnapshotMagic, SnapshotVersion);
+    }
+
+    //mapping is the file the reader reads in place, or null if the reader has its own copy
+    bool LoadSnapshot(CSnapshotReader &reader, const std::shared_ptr<const CMemoryMappedFile> &mapping)
+    {
+        double walkSpeed, bikeSpeed, speedLimit, busStopTime;
+        if (!reader.Read(walkSpeed) || !reader.Read(bikeSpeed) || !reader.Read(speedLimit) || !reader.Read(busStopTime) || !reader.Read(MaxSpeed))
+            return false;
+        if (walkSpeed != Config->WalkSpeed() || bikeSpeed != Config->BikeSpeed() || speedLimit != Config->DefaultSpeedLimit() || busStopTime != Config->BusStopTime())
+            return false;
+
+        std::vector<CStreetMap::TNodeID> ids;
+        std::vector<double> latitudes, longitudes;
+        std::vector<uint64_t> tagOffsets;
+        if (!reader.ReadVector(ids) || !reader.ReadVector(latitudes) || !reader.ReadVector(longitudes) || !reader.ReadVector(tagOffsets))
+            return false;
+        const std::size_t count = ids.size();
+        if (latitudes.size() != count || longitudes.size() != count || tagOffsets.size() != count + 1 || tagOffsets[0] != 0)
+            return false;
+        SortedNodes.reserve(count);
+        for (std::size_t index = 0; index < count; index++)
+        {
+            auto node = std::make_shared<SSnapshotNode>();
+            node->Identifier = ids[index];
+            node->NodeLocation = CStreetMap::TLocation(latitudes[index], longitudes[index]);
+            if (tagOffsets[index + 1] < tagOffsets[index])
+                return false;
+            for (auto tag = tagOffsets[index]; tag < tagOffsets[index + 1]; tag++)
+            {
+                std::string key, value;
+                if (!reader.ReadString(key) || !reader.ReadString(value))
+                    return false;
+                node->Tags.emplace_back(std::move(key), std::move(value));
+            }
+            SortedNodes.push_back(node);
+            NodeIDToIndex[ids[index]] = index;
+        }
+
+        std::vector<CBusSystem::TStopID> stopIDs, nodeStopIDs;
+        std::vector<CStreetMap::TNodeID> stopNodeIDs, nodeIDs;
+        uint64_t routeNodes;
+        if (!reader.ReadVector(stopIDs) || !reader.ReadVector(stopNodeIDs) || !reader.ReadVector(nodeIDs) || !reader.ReadVector(nodeStopIDs) || !reader.Read(routeNodes))
+            return false;
+        if (stopIDs.size() != stopNodeIDs.size() || nodeIDs.size() != nodeStopIDs.size())
+            return false;
+        for (std::size_t index = 0; index < stopIDs.size(); index++)
+            StopIDToNodeID[stopIDs[index]] = stopNodeIDs[index];
+        for (std::size_t index = 0; index < nodeIDs.size(); index++)
+            NodeIDToStopID[nodeIDs[index]] = nodeStopIDs[index];
+        for (uint64_t entry = 0; entry < routeNodes; entry++)
+        {
+            CStreetMap::TNodeID nodeID;
+            uint64_t routeCount;
+            if (!reader.Read(nodeID) || !reader.Read(routeCount))
+                return false;
+            auto &routes = BusRouteInfo[nodeID];
+            for (uint64_t route = 0; route < routeCount; route++)
+            {
+                std::string routeName;
+                CStreetMap::TNodeID nextNodeID;
+                if (!reader.ReadString(routeName) || !reader.Read(nextNodeID))
+                    return false;
+                routes.emplace(std::move(routeName), nextNodeID);
+            }
+        }
+
+        if (!DistanceGraph.Load(reader, mapping) || !TimeGraph.Load(reader, mapping) || !reader.Done())
+            return false;
+        //every vertex has to be one of the nodes, the heuristics look up their locations
+        for (auto graph : {&DistanceGraph, &TimeGraph})
+        {
+            for (auto nodeID : graph->VertexIDToNodeID)
+                if (!NodeIDToIndex.count(nodeID))
+                    return false;
+        }
+        return true;
+    }
+
+    //the planner's own copy of a node, so queries dont need the street map (which a loaded planner might not have)
+    std::shared_ptr<CStreetMap::SNode> NodeByID(CStreetMap::TNodeID id) const
+    {
+        auto search = NodeIDToIndex.find(id);
+        return search == NodeIDToIndex.end() ? nullptr : SortedNodes[search->second];
     }
 
 private:
@@ -74,27 +797,18 @@ private:
     }
 
 
-    //this creates vertices for both routers for every nodes
-    void CreateRouterVertices()
+    //this creates the routers once all the edges are in, only the junctions become vertices
+    void BuildGraphs()
     {
-        //first initilaize empy routing graphs
-        DistanceRouter = std::make_shared<CDijkstraPathRouter>();
-        TimeRouter = std::make_shared<CDijkstraPathRouter>();
-
-        //add vertices to both of the routers
+        //Precompute builds contraction hierarchies on them
+        //with no precompute time there is no point trying, so use bidirectional dijkstra which needs none
+        auto mode = Config->PrecomputeTime() > 0 ? CDijkstraPathRouter::ESearchMode::ContractionHierarchies : CDijkstraPathRouter::ESearchMode::Bidirectional;
+        std::vector<CStreetMap::TNodeID> ids;
+        ids.reserve(SortedNodes.size());
         for (auto &node : SortedNodes)
-        {
-            auto nodeID = node->ID();
-            auto distVID = DistanceRouter->AddVertex(nodeID);
-            auto timeVID = TimeRouter->AddVertex(nodeID);
-
-
-            //make sure to hold bidirectional mapping
-            NodeIDToDistanceVertexID[nodeID] = distVID;
-            NodeIDToTimeVertexID[nodeID] = timeVID;
-            DistanceVertexIDToNodeID[distVID] = nodeID;
-            TimeVertexIDToNodeID[timeVID] = nodeID;
-        }
+            ids.push_back(node->ID());
+        DistanceGraph.Build(ids, mode);
+        TimeGraph.Build(ids, mode);
     }
     // this function should process bus system data and creates stop-node mappings
     void ProcessBusSystem()
@@ -134,9 +848,9 @@ private:
     //this function will go through each and every individual ways
     void ProcessWay(const std::shared_ptr<CStreetMap::SWay> &way)
     {
-        const bool isOneway = way->HasAttribute("oneway") &&
-                              (way->GetAttribute("oneway") == "yes" ||
-                               way->GetAttribute("oneway") == "1");
+        //one lookup, a missing tag comes back as ""
+        const std::string oneway = way->GetAttribute("oneway");
+        const bool isOneway = oneway == "yes" || oneway == "1";
 
 
         // this processes consec node pairs along the way                       
@@ -173,18 +887,44 @@ private:
         if (distance <= 0.0) //if there is no distance it should be invalid so skip it
             return;
 
-        // Distance router
-        DistanceRouter->AddEdge(NodeIDToDistanceVertexID[src],NodeIDToDistanceVertexID[dest],distance);
+        // Distance graph
+        const std::size_t srcIndex = NodeIDToIndex.at(src), destIndex = NodeIDToIndex.at(dest);
+        DistanceGraph.AddEdge(srcIndex, destIndex, distance);
 
-        // Time router calculations
+        // Time graph calculations
         const auto AddTimeEdge = [&](double speed)
         {
-            TimeRouter->AddEdge(NodeIDToTimeVertexID[src], NodeIDToTimeVertexID[dest], distance / speed);
+            TimeGraph.AddEdge(srcIndex, destIndex, distance / speed);
         };
         //these adds the edges for the diff kinds of transportation modes // fo rwalking and biking
         AddTimeEdge(Config->WalkSpeed());
         AddTimeEdge(Config->BikeSpeed());
-        AddTimeEdge(way->HasAttribute("maxspeed") ? ParseSpeedLimit(way->GetAttribute("maxspeed")) : Config->DefaultSpeedLimit());
+        const double carSpeed = way->HasAttribute("maxspeed") ? ParseSpeedLimit(way->GetAttribute("maxspeed")) : Config->DefaultSpeedLimit();
+        AddTimeEdge(carSpeed);
+        MaxSpeed = std::max({MaxSpeed, Config->WalkSpeed(), Config->BikeSpeed(), carSpeed});
+    }
+
+    //gives both routers the node locations so they can run A*
+    //distance edges are great circle distances so the great circle distance to dest is a lower bound,
+    //and dividing by the fastest speed makes it a lower bound on time. bus edges go at the default speed limit
+    //plus the stop time so they are covered too
+    void SetRouterHeuristics()
+    {
+        //the location of every vertex, which are only the junctions of each graph
+        auto vertexLocations = [this](const SCompactGraph &graph)
+        {
+            std::vector<CDijkstraPathRouter::TLocation> locations;
+            locations.reserve(graph.VertexIDToNodeID.size());
+            for (auto nodeID : graph.VertexIDToNodeID)
+                locations.push_back(NodeByID(nodeID)->Location());
+            return locations;
+        };
+        DistanceGraph.Router->SetHeuristic(vertexLocations(DistanceGraph), [](const CDijkstraPathRouter::TLocation &src, const CDijkstraPathRouter::TLocation &dest)
+                                     { return SGeographicUtils::HaversineDistanceInMiles(src, dest); });
+
+        const double maxSpeed = std::max(MaxSpeed, Config->DefaultSpeedLimit());
+        TimeGraph.Router->SetHeuristic(vertexLocations(TimeGraph), [maxSpeed](const CDijkstraPathRouter::TLocation &src, const CDijkstraPathRouter::TLocation &dest)
+                                 { return SGeographicUtils::HaversineDistanceInMiles(src, dest) / maxSpeed; });
     }
 
     double ParseSpeedLimit(const std::string &speed) const
@@ -237,12 +977,62 @@ private:
                 const double distance = SGeographicUtils::HaversineDistanceInMiles(srcNode->Location(), destNode->Location());
                 const double busTime = (distance / Config->DefaultSpeedLimit()) +(Config->BusStopTime() / 3600.0);// here we have to add the bus stop time
 
-                TimeRouter->AddEdge(NodeIDToTimeVertexID[srcID],NodeIDToTimeVertexID[destID],busTime); // add s teh time edge for route of bus
+                TimeGraph.AddEdge(NodeIDToIndex.at(srcID), NodeIDToIndex.at(destID), busTime); // add s teh time edge for route of bus
             }
         }
     }
 
 public:
+    //every thread gets its own scratch space for the router searches, so queries never share any mutable state
+    //one context works with both routers (and with other planners on the same thread)
+    static CDijkstraPathRouter::CQueryContext &QueryContext()
+    {
+        thread_local CDijkstraPathRouter::CQueryContext context;
+        return context;
+    }
+
+    //runs query(0) ... query(count - 1) on a pool of threadcount worker threads (0 means one per core)
+    //the workers take the next index from a shared counter, so a few long queries dont hold up a whole slice
+    //the first exception a query throws is rethrown here once every worker is done
+    static void ParallelQueries(std::size_t count, std::size_t threadcount, const std::function<void(std::size_t)> &query)
+    {
+        if (threadcount == 0)
+            threadcount = std::max(1u, std::thread::hardware_concurrency());
+        threadcount = std::min(threadcount, count);
+        if (threadcount <= 1)
+        {
+            for (std::size_t index = 0; index < count; ++index)
+                query(index);
+            return;
+        }
+
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        auto worker = [&]()
+        {
+            try
+            {
+                for (std::size_t index = next++; index < count; index = next++)
+                    query(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure)
+                    failure = std::current_exception();
+                next = count; //the other workers stop after their current query
+            }
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threadcount; ++t)
+            workers.emplace_back(worker);
+        for (auto &thread : workers)
+            thread.join();
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+
 // this next functino we need to make shoould find the bus routes between the two ndoes
     std::string FindBusRouteBetweenNodes(const CStreetMap::TNodeID &src,const CStreetMap::TNodeID &dest) const
     {
@@ -356,8 +1146,30 @@ CDijkstraTransportationPlanner::CDijkstraTransportationPlanner(std::shared_ptr<S
 {
 }
 
+CDijkstraTransportationPlanner::CDijkstraTransportationPlanner(std::shared_ptr<SConfiguration> config, std::shared_ptr<CDataSource> snapshot)
+    : DImplementation(std::make_unique<SImplementation>(config, snapshot))
+{
+}
+
+CDijkstraTransportationPlanner::CDijkstraTransportationPlanner(std::shared_ptr<SConfiguration> config, std::shared_ptr<const CMemoryMappedFile> snapshot)
+    : DImplementation(std::make_unique<SImplementation>(config, snapshot))
+{
+}
+
 CDijkstraTransportationPlanner::~CDijkstraTransportationPlanner() = default; // this is the destructor
 
+bool CDijkstraTransportationPlanner::Save(std::shared_ptr<CDataSink> sink) const
+{
+    try
+    {
+        return DImplementation->SaveSnapshot(sink);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return false;
+    }
+}
+
 std::size_t CDijkstraTransportationPlanner::NodeCount() const noexcept
 {
     return DImplementation->SortedNodes.size();
@@ -372,39 +1184,14 @@ std::shared_ptr<CStreetMap::SNode> CDijkstraTransportationPlanner::SortedNodeByI
     return nullptr;
 }
 
-double CDijkstraTransportationPlanner::FindShortestPath(TNodeID src, TNodeID dest, std::vector<TNodeID> &path)
+double CDijkstraTransportationPlanner::FindShortestPath(TNodeID src, TNodeID dest, std::vector<TNodeID> &path) const
 {
     // always clear the output path
     path.clear();
 
-    // Make sure source and destination are valid again if not throw nopathexists
-    if (DImplementation->NodeIDToDistanceVertexID.find(src) == DImplementation->NodeIDToDistanceVertexID.end() ||
-        DImplementation->NodeIDToDistanceVertexID.find(dest) == DImplementation->NodeIDToDistanceVertexID.end())
-    {
-        return CPathRouter::NoPathExists;
-    }
-
-    // vertex id for the source and destination
-    auto destVertex = DImplementation->NodeIDToDistanceVertexID[dest];
-    auto sourceVertex = DImplementation->NodeIDToDistanceVertexID[src];
-
-    // Find shortest path using the distance router
-    std::vector<CPathRouter::TVertexID> routerPath;
-    double dist = DImplementation->DistanceRouter->FindShortestPath(sourceVertex, destVertex, routerPath);
-
-    // no path or dist is infiniite
-    if (dist < 0.0)
-    {
-        return CPathRouter::NoPathExists;
-    }
-
-    // Convert router path (vertex IDs) back to node IDs
-    for (const auto &vertexID : routerPath)
-    {
-        path.push_back(DImplementation->DistanceVertexIDToNodeID[vertexID]);
-    }
-
-    return dist;
+    // the graph unpacks the contracted chains, so the path has every node like before
+    // unknown source or destination is nopathexists
+    return DImplementation->DistanceGraph.FindPath(src, dest, path);
 }
 // this function will find the fastest path between two nodes and return the time it takes to travel that path
 // i think got this down to earth
@@ -417,36 +1204,27 @@ double CDijkstraTransportationPlanner::FindShortestPath(TNodeID src, TNodeID des
 // you cannot take your bike on bus so if you take bus
 // you must walk to it.
 // and you cant ride a bike explicitly after you get off the bus
-double CDijkstraTransportationPlanner::FindFastestPath(TNodeID src, TNodeID dest, std::vector<TTripStep> &path)
+double CDijkstraTransportationPlanner::FindFastestPath(TNodeID src, TNodeID dest, std::vector<TTripStep> &path) const
 {
     path.clear();
-    if (DImplementation->NodeIDToTimeVertexID.find(src) == DImplementation->NodeIDToTimeVertexID.end() ||
-        DImplementation->NodeIDToTimeVertexID.find(dest) == DImplementation->NodeIDToTimeVertexID.end())
-    {
-        return CPathRouter::NoPathExists; //if src or dest not exist, then return nopathexists
-    }
-
-    auto srcVertex = DImplementation->NodeIDToTimeVertexID[src];
-    auto destVertex = DImplementation->NodeIDToTimeVertexID[dest];
-    std::vector<CPathRouter::TVertexID> routerPath;
-    double time = DImplementation->TimeRouter->FindShortestPath(srcVertex, destVertex, routerPath);
+    std::vector<TNodeID> nodePath;
+    double time = DImplementation->TimeGraph.FindPath(src, dest, nodePath);
 
-    if (time < 0.0)
-        return CPathRouter::NoPathExists;
+    if (time == CPathRouter::NoPathExists)
+        return CPathRouter::NoPathExists; //if src or dest not exist or no path, then return nopathexists
 
-    auto StreetMap = DImplementation->Config->StreetMap();
     ETransportationMode prevMode = ETransportationMode::Walk;
 
-    for (size_t i = 0; i < routerPath.size(); ++i)
+    for (size_t i = 0; i < nodePath.size(); ++i)
     {
-        auto currentNodeID = DImplementation->TimeVertexIDToNodeID[routerPath[i]];
+        auto currentNodeID = nodePath[i];
         ETransportationMode tMode = ETransportationMode::Walk;
 
         if (i > 0)
         {
-            auto prevNodeID = DImplementation->TimeVertexIDToNodeID[routerPath[i - 1]];
-            auto prevNode = StreetMap->NodeByID(prevNodeID);
-            auto currentNode = StreetMap->NodeByID(currentNodeID);
+            auto prevNodeID = nodePath[i - 1];
+            auto prevNode = DImplementation->NodeByID(prevNodeID);
+            auto currentNode = DImplementation->NodeByID(currentNodeID);
             std::string busRoute = DImplementation->FindBusRouteBetweenNodes(prevNodeID, currentNodeID);
 
             // Critical: Restrict mode transitions
@@ -511,6 +1289,46 @@ double CDijkstraTransportationPlanner::FindFastestPath(TNodeID src, TNodeID dest
 
     return time;
 }
+// the batch versions just run the single queries above on the worker threads, which is safe because they are const
+// and every thread gets its own query context. each query writes only its own slot so the order matches pairs
+void CDijkstraTransportationPlanner::FindShortestPaths(const std::vector<std::pair<TNodeID, TNodeID>> &pairs, std::vector<double> &distances, std::vector<std::vector<TNodeID>> &paths, std::size_t threadcount) const
+{
+    distances.assign(pairs.size(), CPathRouter::NoPathExists);
+    paths.assign(pairs.size(), std::vector<TNodeID>());
+    SImplementation::ParallelQueries(pairs.size(), threadcount, [&](std::size_t index)
+                                     { distances[index] = FindShortestPath(pairs[index].first, pairs[index].second, paths[index]); });
+}
+
+void CDijkstraTransportationPlanner::FindFastestPaths(const std::vector<std::pair<TNodeID, TNodeID>> &pairs, std::vector<double> &times, std::vector<std::vector<TTripStep>> &paths, std::size_t threadcount) const
+{
+    times.assign(pairs.size(), CPathRouter::NoPathExists);
+    paths.assign(pairs.size(), std::vector<TTripStep>());
+    SImplementation::ParallelQueries(pairs.size(), threadcount, [&](std::size_t index)
+                                     { times[index] = FindFastestPath(pairs[index].first, pairs[index].second, paths[index]); });
+}
+
+// the tables come from the routers, the one to many is a single dijkstra per seed vertex that stops once it has
+// settled every dest and the matrix uses the contraction hierarchy buckets when the routers have one
+std::vector<double> CDijkstraTransportationPlanner::FindShortestDistances(TNodeID src, const std::vector<TNodeID> &dests) const
+{
+    return DImplementation->DistanceGraph.Table({src}, dests, true)[0];
+}
+
+std::vector<std::vector<double>> CDijkstraTransportationPlanner::FindShortestDistanceMatrix(const std::vector<TNodeID> &srcs, const std::vector<TNodeID> &dests) const
+{
+    return DImplementation->DistanceGraph.Table(srcs, dests, false);
+}
+
+std::vector<double> CDijkstraTransportationPlanner::FindFastestTimes(TNodeID src, const std::vector<TNodeID> &dests) const
+{
+    return DImplementation->TimeGraph.Table({src}, dests, true)[0];
+}
+
+std::vector<std::vector<double>> CDijkstraTransportationPlanner::FindFastestTimeMatrix(const std::vector<TNodeID> &srcs, const std::vector<TNodeID> &dests) const
+{
+    return DImplementation->TimeGraph.Table(srcs, dests, false);
+}
+
 // this functino will return a description of the path so we can read set of steps and rit returns true if the path description
 // is created in the process //fixed this i think
 
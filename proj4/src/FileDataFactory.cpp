@@ -1,9 +1,10 @@
 #include "FileDataFactory.h"
 #include "FileDataSource.h"
+#include "MMapDataSource.h"
 #include "FileDataSink.h"
 #include <filesystem>
 
-CFileDataFactory::CFileDataFactory(const std::string &path){
+CFileDataFactory::CFileDataFactory(const std::string &path, std::size_t mapthreshold) : DMapThreshold(mapthreshold){
     if(path.empty()){
         DBasePath = "./";
     }
@@ -13,6 +14,15 @@ CFileDataFactory::CFileDataFactory(const std::string &path){
 }
 
 std::shared_ptr< CDataSource > CFileDataFactory::CreateSource(const std::string &name) noexcept{
+    // mapping only pays off once the file is big, and a file that cant be mapped is still read as a stream
+    std::error_code ErrorCode;
+    auto Size = std::filesystem::file_size(DBasePath + name, ErrorCode);
+    if(!ErrorCode && DMapThreshold != NeverMap && Size >= DMapThreshold){
+        auto Source = std::make_shared<CMMapDataSource>(DBasePath + name);
+        if(Source->Valid()){
+            return Source;
+        }
+    }
     return std::make_shared<CFileDataSource>(DBasePath + name);
 }
 
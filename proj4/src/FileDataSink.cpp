@@ -2,7 +2,7 @@
 
 
 CFileDataSink::CFileDataSink(const std::string &filename){
-    DFile.open(filename);
+    DFile.open(filename, std::ios::binary);
 }
 
 bool CFileDataSink::Put(const char &ch) noexcept{
@@ -1,44 +1,94 @@
 #include "FileDataSource.h"
+#include <algorithm>
 
-CFileDataSource::CFileDataSource(const std::string &filename){
-    DFile.open(filename);
+CFileDataSource::CFileDataSource(const std::string &filename) : DOffset(0){
+    DFile.open(filename, std::ios::binary);
+    FillBlock();
+}
+
+// reads the next block once the current one is used up, leaves it empty at the end of the file
+void CFileDataSource::FillBlock(){
+    if(DOffset < DBlock.size()){
+        return;
+    }
+    DOffset = 0;
+    DBlock.resize(BlockSize);
     if(DFile.good()){
-        DFile.peek();
+        DFile.read(DBlock.data(), BlockSize);
+        DBlock.resize(DFile.gcount());
+    }
+    else{
+        DBlock.clear();
     }
 }
 
 bool CFileDataSource::End() const noexcept{
-    return DFile.eof();
+    return DOffset >= DBlock.size();
 }
 
 bool CFileDataSource::Get(char &ch) noexcept{
-    if(!DFile.good()){
+    if(End()){
         return false;
     }
-    ch = DFile.get();
-    if(ch != EOF){
-        DFile.peek();
-    }
-    return ch != EOF;
+    ch = DBlock[DOffset++];
+    FillBlock();
+    return true;
 }
 
 bool CFileDataSource::Peek(char &ch) noexcept{
-    if(!DFile.good()){
+    if(End()){
         return false;
     }
-    ch = DFile.peek();
-    return ch != EOF;
+    ch = DBlock[DOffset];
+    return true;
 }
 
 bool CFileDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
-    if(!DFile.good()){
-        return false;
-    }
-    char TempCh;
     buf.clear();
-    buf.reserve(count);
-    while(buf.size() < count && Get(TempCh)){
-        buf.push_back(TempCh);
+    try{
+        buf.reserve(std::min(count, BlockSize));
+        while(buf.size() < count && !End()){
+            std::size_t Length = std::min(count - buf.size(), DBlock.size() - DOffset);
+            buf.insert(buf.end(), DBlock.begin() + DOffset, DBlock.begin() + DOffset + Length);
+            DOffset += Length;
+            // a big read goes straight from the file into buf instead of through the block, a block at a time so
+            // buf only grows by what the file still has, not by however much was asked for
+            while(DOffset == DBlock.size() && count - buf.size() >= BlockSize && DFile.good()){
+                std::size_t Start = buf.size();
+                buf.resize(Start + BlockSize);
+                DFile.read(buf.data() + Start, BlockSize);
+                buf.resize(Start + DFile.gcount());
+            }
+            FillBlock();
+        }
+    }
+    catch(const std::bad_alloc &){
+        // buf keeps what was read before the allocation failed and the source carries on after it
     }
     return !buf.empty();
 }
+
+bool CFileDataSource::Borrow(std::string_view &chunk, std::size_t max) noexcept{
+    if(End()){
+        chunk = std::string_view();
+        return false;
+    }
+    std::size_t Length = std::min(max, DBlock.size() - DOffset);
+    if(DOffset + Length < DBlock.size()){
+        chunk = std::string_view(DBlock.data() + DOffset, Length);
+        DOffset += Length;
+        return true;
+    }
+    // the whole rest of the block goes out, so the next block is read into the other buffer
+    try{
+        DLentBlock.reserve(BlockSize);
+    }
+    catch(const std::bad_alloc &){
+        return false;
+    }
+    std::swap(DBlock, DLentBlock);
+    chunk = std::string_view(DLentBlock.data() + DOffset, Length);
+    DOffset = DBlock.size();
+    FillBlock();
+    return true;
+}
@@ -0,0 +1,65 @@
+#include "MMapDataSource.h"
+#include <algorithm>
+
+CMMapDataSource::CMMapDataSource(const std::string &filename) : CMMapDataSource(std::make_shared<CMemoryMappedFile>(filename)){
+
+}
+
+CMMapDataSource::CMMapDataSource(std::shared_ptr<const CMemoryMappedFile> file) : DFile(std::move(file)), DOffset(0){
+
+}
+
+bool CMMapDataSource::Valid() const noexcept{
+    return DFile && DFile->Valid();
+}
+
+bool CMMapDataSource::End() const noexcept{
+    return Remaining().empty();
+}
+
+bool CMMapDataSource::Get(char &ch) noexcept{
+    if(End()){
+        return false;
+    }
+    ch = DFile->Data()[DOffset++];
+    return true;
+}
+
+bool CMMapDataSource::Peek(char &ch) noexcept{
+    if(End()){
+        return false;
+    }
+    ch = DFile->Data()[DOffset];
+    return true;
+}
+
+bool CMMapDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    std::string_view Rest = Remaining();
+    std::size_t Length = std::min(count, Rest.size());
+    try{
+        buf.assign(Rest.data(), Rest.data() + Length);
+    }
+    catch(const std::bad_alloc &){
+        buf.clear();
+        return false;
+    }
+    DOffset += Length;
+    return !buf.empty();
+}
+
+bool CMMapDataSource::Borrow(std::string_view &chunk, std::size_t max) noexcept{
+    chunk = Remaining().substr(0, max);
+    DOffset += chunk.size();
+    return !chunk.empty();
+}
+
+std::string_view CMMapDataSource::Contents() const noexcept{
+    if(!Valid() || !DFile->Size()){
+        return std::string_view();
+    }
+    return std::string_view(DFile->Data(), DFile->Size());
+}
+
+std::string_view CMMapDataSource::Remaining() const noexcept{
+    return Contents().substr(std::min(DOffset, Contents().size()));
+}
@@ -0,0 +1,50 @@
+#include "MemoryMappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+CMemoryMappedFile::CMemoryMappedFile(const std::string &filename) : DData(nullptr), DSize(0), DValid(false){
+    int FileDescriptor = open(filename.c_str(), O_RDONLY);
+    if(FileDescriptor < 0){
+        return;
+    }
+    struct stat Status;
+    if(fstat(FileDescriptor, &Status) == 0){
+        DSize = Status.st_size;
+        if(DSize == 0){
+            // mmap cant map nothing, an empty file is still a valid (empty) mapping
+            DValid = true;
+        }
+        else{
+            void *Mapping = mmap(nullptr, DSize, PROT_READ, MAP_SHARED, FileDescriptor, 0);
+            if(Mapping != MAP_FAILED){
+                DData = static_cast<const char *>(Mapping);
+                DValid = true;
+            }
+            else{
+                DSize = 0;
+            }
+        }
+    }
+    // the mapping keeps its own reference to the file
+    close(FileDescriptor);
+}
+
+CMemoryMappedFile::~CMemoryMappedFile(){
+    if(DData){
+        munmap(const_cast<char *>(DData), DSize);
+    }
+}
+
+bool CMemoryMappedFile::Valid() const noexcept{
+    return DValid;
+}
+
+const char *CMemoryMappedFile::Data() const noexcept{
+    return DData;
+}
+
+std::size_t CMemoryMappedFile::Size() const noexcept{
+    return DSize;
+}
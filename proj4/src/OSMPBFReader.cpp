@@ -0,0 +1,452 @@
+#include "OSMPBFReader.h"
+#include <zlib.h>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <cstdint>
+
+struct COSMPBFReader::SImplementation {
+    //limits from the format spec, anything bigger is a damaged file
+    static constexpr std::size_t MaxBlobHeaderSize = 64 * 1024;
+    static constexpr std::size_t MaxBlobSize = 32 * 1024 * 1024;
+    //coordinates are stored in units of 1e-9 degrees
+    static constexpr double NanoDegrees = 1e9;
+
+    //one field at a time out of an encoded protobuf message, varint fields land in Value and length delimited ones
+    //(strings, sub messages, packed arrays) in Bytes. Next is false at the end of the message or once it hits bytes
+    //that arent a field, and then Damaged is set
+    struct SMessage {
+        std::string_view Data;
+        bool Damaged = false;
+        uint32_t Field = 0;
+        uint32_t WireType = 0;
+        uint64_t Value = 0;
+        std::string_view Bytes;
+
+        SMessage(std::string_view data) : Data(data) {
+        }
+
+        bool Next() noexcept {
+            uint64_t key;
+            if (Data.empty()) {
+                return false;
+            }
+            if (!ReadVarint(Data, key) || (key >> 3) == 0 || (key >> 3) > UINT32_MAX) {
+                return Fail();
+            }
+            Field = uint32_t(key >> 3);
+            WireType = uint32_t(key & 7);
+            switch (WireType) {
+                case 0: //varint
+                    return ReadVarint(Data, Value) || Fail();
+                case 1: //fixed 64 bit, nothing in the OSM schema uses it
+                    return Skip(8);
+                case 2: { //length delimited
+                    uint64_t length;
+                    if (!ReadVarint(Data, length) || length > Data.size()) {
+                        return Fail();
+                    }
+                    Bytes = Data.substr(0, length);
+                    Data.remove_prefix(length);
+                    return true;
+                }
+                case 5: //fixed 32 bit
+                    return Skip(4);
+                default: //the old group wire types arent in the schema either
+                    return Fail();
+            }
+        }
+
+        bool Skip(std::size_t count) noexcept {
+            if (Data.size() < count) {
+                return Fail();
+            }
+            Data.remove_prefix(count);
+            return true;
+        }
+
+        bool Fail() noexcept {
+            Damaged = true;
+            Data = std::string_view();
+            return false;
+        }
+    };
+
+    //a data blob as it is in the file, Damaged if the file ended or broke off in the middle of it
+    struct SBlob {
+        std::string_view Data;
+        bool Damaged;
+    };
+
+    std::vector<SBlob> Blobs;
+    bool IsValid = false;
+
+    static bool ReadVarint(std::string_view &data, uint64_t &value) noexcept {
+        value = 0;
+        for (int shift = 0; shift < 64 && !data.empty(); shift += 7) {
+            auto byte = static_cast<unsigned char>(data.front());
+            data.remove_prefix(1);
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static int64_t ZigZag(uint64_t value) noexcept {
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    //a repeated number field, which writers are allowed to store packed or one value per field
+    template <typename TFunction> static bool ForEachVarint(const SMessage &field, TFunction function) {
+        if (field.WireType == 0) {
+            function(field.Value);
+            return true;
+        }
+        if (field.WireType != 2) {
+            return false;
+        }
+        uint64_t value;
+        for (auto data = field.Bytes; !data.empty(); ) {
+            if (!ReadVarint(data, value)) {
+                return false;
+            }
+            function(value);
+        }
+        return true;
+    }
+
+    //the BlobHeader (type and size) and Blob at the start of document, document is moved past them
+    static bool NextBlob(std::string_view &document, std::string_view &type, std::string_view &blob) noexcept {
+        if (document.size() < 4) {
+            return false;
+        }
+        std::size_t headerSize = 0;
+        for (int index = 0; index < 4; index++) {
+            headerSize = (headerSize << 8) | static_cast<unsigned char>(document[index]);
+        }
+        if (headerSize > MaxBlobHeaderSize || headerSize > document.size() - 4) {
+            return false;
+        }
+        SMessage header(document.substr(4, headerSize));
+        uint64_t blobSize = 0;
+        bool hasType = false, hasSize = false;
+        while (header.Next()) {
+            if (header.Field == 1 && header.WireType == 2) {
+                type = header.Bytes;
+                hasType = true;
+            } else if (header.Field == 3 && header.WireType == 0) {
+                blobSize = header.Value;
+                hasSize = true;
+            }
+        }
+        if (header.Damaged || !hasType || !hasSize || blobSize > MaxBlobSize || blobSize > document.size() - 4 - headerSize) {
+            return false;
+        }
+        blob = document.substr(4 + headerSize, blobSize);
+        document.remove_prefix(4 + headerSize + blobSize);
+        return true;
+    }
+
+    //the block a blob holds, stored raw or inflated into buffer. other compressions (lzma, lz4, zstd) are optional in
+    //the format and arent supported
+    static bool Inflate(std::string_view blob, std::string &buffer, std::string_view &data) {
+        SMessage message(blob);
+        std::string_view compressed;
+        uint64_t rawSize = 0;
+        bool hasData = false, isCompressed = false;
+        while (message.Next()) {
+            if (message.Field == 1 && message.WireType == 2) {
+                data = message.Bytes;
+                hasData = true;
+            } else if (message.Field == 2 && message.WireType == 0) {
+                rawSize = message.Value;
+            } else if (message.Field == 3 && message.WireType == 2) {
+                compressed = message.Bytes;
+                hasData = isCompressed = true;
+            } else if (message.Field >= 4 && message.Field <= 7) {
+                return false;
+            }
+        }
+        if (message.Damaged || !hasData) {
+            return false;
+        }
+        if (!isCompressed) {
+            return true;
+        }
+        if (rawSize > MaxBlobSize) {
+            return false;
+        }
+        buffer.resize(rawSize);
+        uLongf length = rawSize;
+        if (uncompress(reinterpret_cast<Bytef *>(buffer.data()), &length, reinterpret_cast<const Bytef *>(compressed.data()), compressed.size()) != Z_OK || length != rawSize) {
+            return false;
+        }
+        data = buffer;
+        return true;
+    }
+
+    //a reader has to refuse files that need a feature it doesnt know, like history files
+    static bool CheckHeader(std::string_view block) {
+        SMessage message(block);
+        while (message.Next()) {
+            if (message.Field == 4 && message.WireType == 2 && message.Bytes != "OsmSchema-V0.6" && message.Bytes != "DenseNodes") {
+                return false;
+            }
+        }
+        return !message.Damaged;
+    }
+
+    struct SBlockDecoder;
+};
+
+//decodes one PrimitiveBlock, the groups in it are read after the whole block so the string table and the coordinate
+//scale are known whichever order the writer put the fields in
+struct COSMPBFReader::SImplementation::SBlockDecoder {
+    CHandler &Handler;
+    std::vector<std::string_view> Strings;
+    int64_t Granularity = 100;
+    int64_t LatOffset = 0;
+    int64_t LonOffset = 0;
+    //reused from entity to entity
+    TTags Tags;
+    std::vector<uint64_t> Refs;
+    std::vector<uint64_t> Keys;
+    std::vector<uint64_t> Values;
+
+    SBlockDecoder(CHandler &handler) : Handler(handler) {
+    }
+
+    //dividing the exact integer is correctly rounded, so it gives the same double strtod does for the decimal text of
+    //the coordinate in an XML file (multiplying by 1e-9 can be one bit off)
+    double Coordinate(int64_t offset, int64_t value) const noexcept {
+        return double(int64_t(uint64_t(offset) + uint64_t(Granularity) * uint64_t(value))) / NanoDegrees;
+    }
+
+    //Keys and Values are indexes into the string table
+    bool MakeTags() {
+        Tags.clear();
+        if (Keys.size() != Values.size()) {
+            return false;
+        }
+        for (std::size_t index = 0; index < Keys.size(); index++) {
+            if (Keys[index] >= Strings.size() || Values[index] >= Strings.size()) {
+                return false;
+            }
+            Tags.emplace_back(Strings[Keys[index]], Strings[Values[index]]);
+        }
+        return true;
+    }
+
+    bool Decode(std::string_view block) {
+        SMessage message(block);
+        std::vector<std::string_view> groups;
+        while (message.Next()) {
+            if (message.Field == 1 && message.WireType == 2) {
+                SMessage table(message.Bytes);
+                while (table.Next()) {
+                    if (table.Field == 1 && table.WireType == 2) {
+                        Strings.push_back(table.Bytes);
+                    }
+                }
+                if (table.Damaged) {
+                    return false;
+                }
+            } else if (message.Field == 2 && message.WireType == 2) {
+                groups.push_back(message.Bytes);
+            } else if (message.Field == 17 && message.WireType == 0) {
+                Granularity = int32_t(message.Value);
+            } else if (message.Field == 19 && message.WireType == 0) {
+                LatOffset = int64_t(message.Value);
+            } else if (message.Field == 20 && message.WireType == 0) {
+                LonOffset = int64_t(message.Value);
+            }
+        }
+        if (message.Damaged) {
+            return false;
+        }
+        for (auto group : groups) {
+            SMessage entities(group);
+            while (entities.Next()) {
+                if (entities.WireType != 2) {
+                    continue;
+                }
+                bool valid = true;
+                if (entities.Field == 1) {
+                    valid = DecodeNode(entities.Bytes);
+                } else if (entities.Field == 2) {
+                    valid = DecodeDenseNodes(entities.Bytes);
+                } else if (entities.Field == 3) {
+                    valid = DecodeWay(entities.Bytes);
+                }
+                if (!valid) {
+                    return false;
+                }
+            }
+            if (entities.Damaged) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool DecodeNode(std::string_view node) {
+        SMessage message(node);
+        int64_t id = 0, lat = 0, lon = 0;
+        Keys.clear();
+        Values.clear();
+        while (message.Next()) {
+            bool valid = true;
+            if (message.Field == 1 && message.WireType == 0) {
+                id = ZigZag(message.Value);
+            } else if (message.Field == 2) {
+                valid = ForEachVarint(message, [this](uint64_t key) { Keys.push_back(key); });
+            } else if (message.Field == 3) {
+                valid = ForEachVarint(message, [this](uint64_t value) { Values.push_back(value); });
+            } else if (message.Field == 8 && message.WireType == 0) {
+                lat = ZigZag(message.Value);
+            } else if (message.Field == 9 && message.WireType == 0) {
+                lon = ZigZag(message.Value);
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+        if (message.Damaged || !MakeTags()) {
+            return false;
+        }
+        Handler.Node(uint64_t(id), Coordinate(LatOffset, lat), Coordinate(LonOffset, lon), Tags);
+        return true;
+    }
+
+    //ids and coordinates are each delta coded from the node before, and the tags of every node are in one array of
+    //key, value, key, value, ... 0 where the 0 (the empty string) ends a node's tags
+    bool DecodeDenseNodes(std::string_view dense) {
+        SMessage message(dense);
+        std::vector<int64_t> ids, lats, lons;
+        std::vector<uint64_t> keysValues;
+        while (message.Next()) {
+            bool valid = true;
+            if (message.Field == 1) {
+                valid = ForEachVarint(message, [&ids](uint64_t value) { ids.push_back(ZigZag(value)); });
+            } else if (message.Field == 8) {
+                valid = ForEachVarint(message, [&lats](uint64_t value) { lats.push_back(ZigZag(value)); });
+            } else if (message.Field == 9) {
+                valid = ForEachVarint(message, [&lons](uint64_t value) { lons.push_back(ZigZag(value)); });
+            } else if (message.Field == 10) {
+                valid = ForEachVarint(message, [&keysValues](uint64_t value) { keysValues.push_back(value); });
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+        if (message.Damaged || lats.size() != ids.size() || lons.size() != ids.size()) {
+            return false;
+        }
+        uint64_t id = 0;
+        int64_t lat = 0, lon = 0;
+        std::size_t next = 0;
+        for (std::size_t index = 0; index < ids.size(); index++) {
+            id += uint64_t(ids[index]);
+            lat = int64_t(uint64_t(lat) + uint64_t(lats[index]));
+            lon = int64_t(uint64_t(lon) + uint64_t(lons[index]));
+            Keys.clear();
+            Values.clear();
+            //with no tagged nodes at all the array can be left out
+            while (next < keysValues.size() && keysValues[next] != 0) {
+                if (next + 1 >= keysValues.size()) {
+                    return false;
+                }
+                Keys.push_back(keysValues[next]);
+                Values.push_back(keysValues[next + 1]);
+                next += 2;
+            }
+            next++;
+            if (!MakeTags()) {
+                return false;
+            }
+            Handler.Node(id, Coordinate(LatOffset, lat), Coordinate(LonOffset, lon), Tags);
+        }
+        return true;
+    }
+
+    bool DecodeWay(std::string_view way) {
+        SMessage message(way);
+        uint64_t id = 0;
+        Keys.clear();
+        Values.clear();
+        Refs.clear();
+        while (message.Next()) {
+            bool valid = true;
+            if (message.Field == 1 && message.WireType == 0) {
+                id = message.Value;
+            } else if (message.Field == 2) {
+                valid = ForEachVarint(message, [this](uint64_t key) { Keys.push_back(key); });
+            } else if (message.Field == 3) {
+                valid = ForEachVarint(message, [this](uint64_t value) { Values.push_back(value); });
+            } else if (message.Field == 8) {
+                //node refs are delta coded
+                valid = ForEachVarint(message, [this](uint64_t value) { Refs.push_back((Refs.empty() ? 0 : Refs.back()) + uint64_t(ZigZag(value))); });
+            }
+            if (!valid) {
+                return false;
+            }
+        }
+        if (message.Damaged || !MakeTags()) {
+            return false;
+        }
+        Handler.Way(id, Refs, Tags);
+        return true;
+    }
+};
+
+COSMPBFReader::COSMPBFReader(std::string_view document) {
+    DImplementation = std::make_unique<SImplementation>();
+    std::string_view type, blob;
+    std::string buffer;
+    std::string_view header;
+    if (!SImplementation::NextBlob(document, type, blob) || type != "OSMHeader" || !SImplementation::Inflate(blob, buffer, header) || !SImplementation::CheckHeader(header)) {
+        return;
+    }
+    DImplementation->IsValid = true;
+    while (!document.empty()) {
+        if (!SImplementation::NextBlob(document, type, blob)) {
+            //a cut off or damaged file keeps the blocks before the damage
+            DImplementation->Blobs.push_back({document, true});
+            break;
+        }
+        //blob types other than OSMData are allowed and have to be skipped
+        if (type == "OSMData") {
+            DImplementation->Blobs.push_back({blob, false});
+        }
+    }
+}
+
+COSMPBFReader::~COSMPBFReader() = default;
+
+bool COSMPBFReader::IsPBF(std::string_view document) noexcept {
+    std::string_view type, blob;
+    return SImplementation::NextBlob(document, type, blob) && type == "OSMHeader";
+}
+
+bool COSMPBFReader::Valid() const noexcept {
+    return DImplementation->IsValid;
+}
+
+std::size_t COSMPBFReader::BlockCount() const noexcept {
+    return DImplementation->Blobs.size();
+}
+
+bool COSMPBFReader::DecodeBlock(std::size_t index, CHandler &handler) const {
+    if (index >= DImplementation->Blobs.size() || DImplementation->Blobs[index].Damaged) {
+        return false;
+    }
+    std::string buffer;
+    std::string_view block;
+    if (!SImplementation::Inflate(DImplementation->Blobs[index].Data, buffer, block)) {
+        return false;
+    }
+    SImplementation::SBlockDecoder decoder(handler);
+    return decoder.Decode(block);
+}
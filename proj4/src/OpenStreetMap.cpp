@@ -1,59 +1,276 @@
 #include "OpenStreetMap.h"
 #include "XMLReader.h"
+#include "OSMPBFReader.h"
 #include <memory> //need for different porinters
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <array>
+#include <deque>
+#include <string_view>
+#include <cstdlib>
+#include <cerrno>
+#include <thread>
+#include <exception>
+#include <algorithm>
 //implementation of details 
 struct COpenStreetMap::SImplementation {
-    class SNodeData;
+    class SStringPool;
+    struct SNodeStore;
+    class SNodeHandle;
     class SWayData;
-    std::vector<std::shared_ptr<SNodeData>> NodeList;
+    struct SParser;
+    struct SPBFLoader;
+    class SChunkSource;
+
+    using TSymbol = uint32_t;
+    using TTag = std::pair<TSymbol, TSymbol>; //interned key and value
+
+    static const TTag *FindTag(const SStringPool &strings, const TTag *begin, const TTag *end, std::string_view key) noexcept;
+    static void SetTag(SStringPool &strings, std::vector<TTag> &tags, std::size_t first, std::string_view key, std::string_view value);
+
+    //maps an id to its position in the node store or WayList, filled in while parsing so NodeByID and WayByID are O(1)
+    //its a flat open addressing hash table (linear probing) that is kept at most half full and doubles when it gets there.
+    //a slot only holds the 32 bit position, the id to compare against is looked up in the ids array the position is for,
+    //so the index costs 8 to 16 bytes per entry
+    struct SIDIndex {
+        static constexpr std::size_t NotFound = std::numeric_limits<std::size_t>::max();
+        static constexpr uint32_t Empty = std::numeric_limits<uint32_t>::max();
+        static constexpr int InitialBits = 4;
+        std::vector<uint32_t> Slots; //positions, Empty means the slot is empty
+        std::size_t Count = 0;
+        int Shift = 64 - InitialBits; //the table has 2^(64 - Shift) slots
+
+        SIDIndex() : Slots(std::size_t(1) << InitialBits, Empty) {
+        }
+
+        std::size_t Home(uint64_t id) const noexcept {
+            //fibonacci hashing, the top bits of id * 2^64 / golden ratio spread sequential ids out well
+            return (id * 0x9E3779B97F4A7C15ULL) >> Shift;
+        }
+
+        //adds ids[index], the first index added for an id wins, same as the linear scan finding the first match
+        void Add(const std::vector<uint64_t> &ids, std::size_t index) {
+            if (index >= Empty) {
+                throw std::length_error("too many OSM entities for the id index");
+            }
+            if ((Count + 1) * 2 > Slots.size()) {
+                Grow(ids);
+            }
+            std::size_t mask = Slots.size() - 1;
+            for (std::size_t slot = Home(ids[index]); ; slot = (slot + 1) & mask) {
+                if (Slots[slot] == Empty) {
+                    Slots[slot] = index;
+                    Count++;
+                    return;
+                }
+                if (ids[Slots[slot]] == ids[index]) {
+                    return;
+                }
+            }
+        }
+
+        std::size_t Find(const std::vector<uint64_t> &ids, uint64_t id) const noexcept {
+            std::size_t mask = Slots.size() - 1;
+            for (std::size_t slot = Home(id); Slots[slot] != Empty; slot = (slot + 1) & mask) {
+                if (ids[Slots[slot]] == id) {
+                    return Slots[slot];
+                }
+            }
+            return NotFound;
+        }
+
+        void Grow(const std::vector<uint64_t> &ids) {
+            std::vector<uint32_t> old(Slots.size() * 2, Empty);
+            old.swap(Slots);
+            Shift--;
+            Count = 0;
+            for (auto index : old) {
+                if (index != Empty) {
+                    Add(ids, index);
+                }
+            }
+        }
+    };
+
+    std::shared_ptr<SStringPool> Strings;
+    std::shared_ptr<SNodeStore> Nodes;
     std::vector<std::shared_ptr<SWayData>> WayList;
+    std::vector<TWayID> WayIDs; //same order as WayList, for WayIndex
+    SIDIndex NodeIndex;
+    SIDIndex WayIndex;
+
+    //what Filter started from and left, only filled in once a filter ran
+    SFilterCounts Counts;
+    bool Filtered = false;
+
+    //the parallel loader only splits documents big enough to give every thread at least this much
+    static constexpr std::size_t MinChunkSize = 256 * 1024;
+
+    SImplementation();
+    bool Parse(CXMLReader &reader);
+    bool Decode(const COSMPBFReader &reader, std::size_t first, std::size_t last);
+    void Finish();
+    static std::size_t ThreadCount(std::size_t threads) noexcept;
+    static std::string_view ReadDocument(CDataSource &source, std::string &copy);
+    static std::vector<std::size_t> SplitDocument(std::string_view document, std::size_t threads);
+    static std::unique_ptr<SImplementation> LoadPBF(std::string_view document, std::size_t threads);
+    static std::unique_ptr<SImplementation> Load(CDataSource &source, std::size_t threads);
+    void Merge(SImplementation &part);
+    void Filter(const SFilter &filter);
+    SFilterCounts CurrentCounts() const noexcept;
 };
-//this reps a single ind node in the data
-class COpenStreetMap::SImplementation::SNodeData : public CStreetMap::SNode {
+
+//every distinct tag key and value is stored once here and tags refer to them by a 32 bit id, shared by the nodes and ways
+//of one map (and kept alive by them). the keys the planner looks up for every way are interned first, in WellKnown order,
+//so their ids are fixed and Find gets them with a couple of compares instead of hashing the key
+class COpenStreetMap::SImplementation::SStringPool {
 public:
-    TNodeID Identifier; // this idfnitifies a unique node
-    TLocation Coordinates;// coords of the node so lat and long
-    std::unordered_map<std::string, std::string> Properties;
-//the atteriburtes of th enode
+    static constexpr TSymbol NotInterned = std::numeric_limits<TSymbol>::max();
+    static constexpr std::array<const char *, 4> WellKnown = {"highway", "oneway", "maxspeed", "name"};
+
+    SStringPool() {
+        for (auto key : WellKnown) {
+            Intern(key);
+        }
+    }
+
+    TSymbol Intern(std::string_view str) {
+        auto search = Symbols.find(str);
+        if (search != Symbols.end()) {
+            return search->second;
+        }
+        if (Strings.size() >= NotInterned) {
+            throw std::length_error("too many distinct OSM tag strings");
+        }
+        Strings.emplace_back(str); //a deque never moves what it holds, so the map can key on views of it
+        return Symbols.emplace(Strings.back(), TSymbol(Strings.size() - 1)).first->second;
+    }
+
+    //NotInterned if no tag uses the string, then no entity can have it as a key
+    TSymbol Find(std::string_view str) const noexcept {
+        for (std::size_t index = 0; index < WellKnown.size(); index++) {
+            if (str == WellKnown[index]) {
+                return TSymbol(index);
+            }
+        }
+        auto search = Symbols.find(str);
+        return (search != Symbols.end()) ? search->second : NotInterned;
+    }
+
+    const std::string &String(TSymbol symbol) const noexcept {
+        return Strings[symbol];
+    }
+
+    std::size_t Size() const noexcept {
+        return Strings.size();
+    }
+
+private:
+    std::unordered_map<std::string_view, TSymbol> Symbols; //views of Strings so looking up a view never allocates
+    std::deque<std::string> Strings;
+};
+
+//tag lists are short so a scan over the ids is quicker than any map, the only hashing is finding the key's id
+const COpenStreetMap::SImplementation::TTag *COpenStreetMap::SImplementation::FindTag(const SStringPool &strings, const TTag *begin, const TTag *end, std::string_view key) noexcept {
+    auto symbol = strings.Find(key);
+    if (symbol == SStringPool::NotInterned) {
+        return end;
+    }
+    for (auto tag = begin; tag != end; tag++) {
+        if (tag->first == symbol) {
+            return tag;
+        }
+    }
+    return end;
+}
+
+//sets a tag in tags[first..], a repeated key overwrites its value like it did with the old per entity maps
+void COpenStreetMap::SImplementation::SetTag(SStringPool &strings, std::vector<TTag> &tags, std::size_t first, std::string_view key, std::string_view value) {
+    auto keySymbol = strings.Intern(key);
+    auto valueSymbol = strings.Intern(value);
+    for (std::size_t tag = first; tag < tags.size(); tag++) {
+        if (tags[tag].first == keySymbol) {
+            tags[tag].second = valueSymbol;
+            return;
+        }
+    }
+    tags.emplace_back(keySymbol, valueSymbol);
+}
+
+//all the nodes, stored as struct of arrays so a node is its id, lat and lon plus one tag offset (about 32 bytes)
+//instead of its own heap object with its own hash map. the tags of node i are Tags[TagOffsets[i] .. TagOffsets[i + 1])
+//in the order they were read, most nodes have none
+struct COpenStreetMap::SImplementation::SNodeStore {
+    std::vector<TNodeID> IDs;
+    std::vector<double> Latitudes;
+    std::vector<double> Longitudes;
+    std::vector<std::size_t> TagOffsets = {0};
+    std::vector<TTag> Tags;
+    std::shared_ptr<const SStringPool> Strings;
+
+    std::size_t Count() const noexcept {
+        return IDs.size();
+    }
+
+    const TTag *TagsBegin(std::size_t index) const noexcept {
+        return Tags.data() + TagOffsets[index];
+    }
+
+    const TTag *TagsEnd(std::size_t index) const noexcept {
+        return Tags.data() + TagOffsets[index + 1];
+    }
+};
+
+//this reps a single ind node in the data, it is just a position in the node store, made when someone asks for a node
+//it keeps the store alive so it stays valid even after the map is gone, same as the old per node objects did
+class COpenStreetMap::SImplementation::SNodeHandle : public CStreetMap::SNode {
+public:
+    std::shared_ptr<const SNodeStore> Store;
+    std::size_t Index;
+
+    SNodeHandle(std::shared_ptr<const SNodeStore> store, std::size_t index) : Store(std::move(store)), Index(index) {
+    }
+
     TNodeID ID() const noexcept override {
-        return Identifier;//returns unique id
+        return Store->IDs[Index];//returns unique id
     }
 
     TLocation Location() const noexcept override {
-        return Coordinates;//obv returns the coords
+        return TLocation(Store->Latitudes[Index], Store->Longitudes[Index]);//obv returns the coords
     }
 
     std::size_t AttributeCount() const noexcept override {
-        return Properties.size();//returns the number of attributes
+        return Store->TagOffsets[Index + 1] - Store->TagOffsets[Index];//returns the number of attributes
     }
 
     std::string GetAttributeKey(std::size_t idx) const noexcept override {
-        if (idx >= Properties.size()) {
+        if (idx >= AttributeCount()) {
             return "";
         }
-        auto iter = std::next(Properties.begin(), idx);
-        return iter->first;
+        return Store->Strings->String(Store->TagsBegin(Index)[idx].first);
     }
 
     bool HasAttribute(const std::string &key) const noexcept override {
-        return Properties.count(key) > 0;
+        return FindTag(*Store->Strings, Store->TagsBegin(Index), Store->TagsEnd(Index), key) != Store->TagsEnd(Index);
     }
 
     std::string GetAttribute(const std::string &key) const noexcept override {
         //gets the value of attribtue by the key 
-        auto iter = Properties.find(key);
-        return (iter != Properties.end()) ? iter->second : "";
+        auto tag = FindTag(*Store->Strings, Store->TagsBegin(Index), Store->TagsEnd(Index), key);
+        return (tag != Store->TagsEnd(Index)) ? Store->Strings->String(tag->second) : "";
     }
 };
 
 class COpenStreetMap::SImplementation::SWayData : public CStreetMap::SWay {
 public:
-    TWayID Identifier;
+    TWayID Identifier = CStreetMap::InvalidWayID;
     std::vector<TNodeID> NodeReferences;
-    std::unordered_map<std::string, std::string> Properties;
+    std::vector<TTag> Tags; //in the order they were read
+    std::shared_ptr<const SStringPool> Strings;
 
     TWayID ID() const noexcept override {
         return Identifier;
@@ -72,103 +289,606 @@ public:
     }
 //count the num of attributes the way has
     std::size_t AttributeCount() const noexcept override {
-        return Properties.size();
+        return Tags.size();
     }
 //get attribtue key by index
     std::string GetAttributeKey(std::size_t idx) const noexcept override {
-        if (idx >= Properties.size()) {
+        if (idx >= Tags.size()) {
             return "";
         }
-        auto iter = std::next(Properties.begin(), idx);
-        return iter->first;
+        return Strings->String(Tags[idx].first);
     }
 
     bool HasAttribute(const std::string &key) const noexcept override {
-        return Properties.count(key) > 0;
+        return FindTag(*Strings, Tags.data(), Tags.data() + Tags.size(), key) != Tags.data() + Tags.size();
     }
 
     std::string GetAttribute(const std::string &key) const noexcept override {
-        auto iter = Properties.find(key);
-        return (iter != Properties.end()) ? iter->second : "";
+        auto tag = FindTag(*Strings, Tags.data(), Tags.data() + Tags.size(), key);
+        return (tag != Tags.data() + Tags.size()) ? Strings->String(tag->second) : "";
     }
 };
 
-COpenStreetMap::COpenStreetMap(std::shared_ptr<CXMLReader> source) {
-    DImplementation = std::make_unique<SImplementation>();
-    
-    SXMLEntity xmlEntity;
-    std::shared_ptr<SImplementation::SNodeData> activeNode = nullptr;
-    std::shared_ptr<SImplementation::SWayData> activeWay = nullptr;
-    
-    while (source->ReadEntity(xmlEntity)) {
-        if (xmlEntity.DType == SXMLEntity::EType::StartElement) {
-            if (xmlEntity.DNameData == "node") {
-                activeNode = std::make_shared<SImplementation::SNodeData>();
-                activeWay = nullptr;
-                
-                for (const auto& attribute : xmlEntity.DAttributes) {
-                    if (attribute.first == "id") {
-                        activeNode->Identifier = std::stoull(attribute.second);
-                    } else if (attribute.first == "lat") {
-                        activeNode->Coordinates.first = std::stod(attribute.second);
-                    } else if (attribute.first == "lon") {
-                        activeNode->Coordinates.second = std::stod(attribute.second);
-                    } else {
-                        activeNode->Properties[attribute.first] = attribute.second;
-                    }
+//builds the map straight from the XML reader's callbacks, the element names and attributes are looked at where expat
+//has them and only the tag strings the pool hasnt seen yet ever get copied
+struct COpenStreetMap::SImplementation::SParser : public CXMLReader::CHandler {
+    SImplementation &Map;
+    SStringPool &Strings;
+    SNodeStore &Nodes;
+    //the node being read goes straight into the store, its tags are the ones after TagOffsets.back()
+    //it only counts (gets its TagOffsets entry) once its end element is read
+    bool ActiveNode = false;
+    std::shared_ptr<SWayData> ActiveWay = nullptr;
+
+    SParser(SImplementation &map) : Map(map), Strings(*map.Strings), Nodes(*map.Nodes) {
+    }
+
+    //stoull and stod without making a std::string of the attribute first
+    static uint64_t ParseID(const char *text) {
+        char *end;
+        errno = 0;
+        auto value = std::strtoull(text, &end, 10);
+        if (end == text) {
+            throw std::invalid_argument("stoull");
+        }
+        if (errno == ERANGE) {
+            throw std::out_of_range("stoull");
+        }
+        return value;
+    }
+
+    static double ParseCoordinate(const char *text) {
+        char *end;
+        errno = 0;
+        auto value = std::strtod(text, &end);
+        if (end == text) {
+            throw std::invalid_argument("stod");
+        }
+        if (errno == ERANGE) {
+            throw std::out_of_range("stod");
+        }
+        return value;
+    }
+
+    void SetNodeTag(std::string_view key, std::string_view value) {
+        SetTag(Strings, Nodes.Tags, Nodes.TagOffsets.back(), key, value);
+    }
+
+    void SetWayTag(std::string_view key, std::string_view value) {
+        SetTag(Strings, ActiveWay->Tags, 0, key, value);
+    }
+
+    //throws away a node that was started but never ended
+    void DropActiveNode() {
+        if (ActiveNode) {
+            Nodes.Tags.resize(Nodes.TagOffsets.back());
+            Nodes.IDs.pop_back();
+            Nodes.Latitudes.pop_back();
+            Nodes.Longitudes.pop_back();
+            ActiveNode = false;
+        }
+    }
+
+    void StartElement(const char *name, const char **attributes) override {
+        std::string_view element(name);
+        if (element == "node") {
+            DropActiveNode();
+            TNodeID missingID = CStreetMap::InvalidNodeID; //stays this if there is no id attribute
+            Nodes.IDs.push_back(missingID);
+            Nodes.Latitudes.push_back(0.0);
+            Nodes.Longitudes.push_back(0.0);
+            ActiveNode = true;
+            ActiveWay = nullptr;
+
+            for (auto attribute = attributes; *attribute; attribute += 2) {
+                std::string_view key(attribute[0]);
+                if (key == "id") {
+                    Nodes.IDs.back() = ParseID(attribute[1]);
+                } else if (key == "lat") {
+                    Nodes.Latitudes.back() = ParseCoordinate(attribute[1]);
+                } else if (key == "lon") {
+                    Nodes.Longitudes.back() = ParseCoordinate(attribute[1]);
+                } else {
+                    SetNodeTag(key, attribute[1]);
                 }
-            } else if (xmlEntity.DNameData == "way") { //uif it finds a new way
-                activeWay = std::make_shared<SImplementation::SWayData>();
-                activeNode = nullptr;
-                
-                for (const auto& attribute : xmlEntity.DAttributes) {
-                    if (attribute.first == "id") {
-                        activeWay->Identifier = std::stoull(attribute.second);
-                    } else {
-                        activeWay->Properties[attribute.first] = attribute.second;
-                    }
+            }
+        } else if (element == "way") { //uif it finds a new way
+            ActiveWay = std::make_shared<SWayData>();
+            ActiveWay->Strings = Map.Strings;
+            DropActiveNode();
+
+            for (auto attribute = attributes; *attribute; attribute += 2) {
+                if (std::string_view(attribute[0]) == "id") {
+                    ActiveWay->Identifier = ParseID(attribute[1]);
+                } else {
+                    SetWayTag(attribute[0], attribute[1]);
                 }
-                //way referes to node
-            } else if (xmlEntity.DNameData == "nd" && activeWay) {
-                for (const auto& attribute : xmlEntity.DAttributes) {
-                    if (attribute.first == "ref") {
-                        activeWay->NodeReferences.push_back(std::stoull(attribute.second));
-                    }
+            }
+            //way referes to node
+        } else if (element == "nd" && ActiveWay) {
+            for (auto attribute = attributes; *attribute; attribute += 2) {
+                if (std::string_view(attribute[0]) == "ref") {
+                    ActiveWay->NodeReferences.push_back(ParseID(attribute[1]));
                 }
-                //this is attirbute for the node or way
-            } else if (xmlEntity.DNameData == "tag") {
-                std::string key, value;
-                for (const auto& attribute : xmlEntity.DAttributes) {
-                    if (attribute.first == "k") {
-                        key = attribute.second;
-                    } else if (attribute.first == "v") {
-                        value = attribute.second;
-                    }
+            }
+            //this is attirbute for the node or way
+        } else if (element == "tag") {
+            std::string_view key, value;
+            for (auto attribute = attributes; *attribute; attribute += 2) {
+                std::string_view attributeName(attribute[0]);
+                if (attributeName == "k") {
+                    key = attribute[1];
+                } else if (attributeName == "v") {
+                    value = attribute[1];
                 }
-                if (!key.empty()) {
-                    if (activeNode) {
-                        activeNode->Properties[key] = value;
-                    } else if (activeWay) {
-                        activeWay->Properties[key] = value;
+            }
+            if (!key.empty()) {
+                if (ActiveNode) {
+                    SetNodeTag(key, value);
+                } else if (ActiveWay) {
+                    SetWayTag(key, value);
+                }
+            }
+        }
+    }
+
+    void EndElement(const char *name) override {
+        std::string_view element(name);
+        if (element == "node" && ActiveNode) {
+            Map.NodeIndex.Add(Nodes.IDs, Nodes.IDs.size() - 1);
+            Nodes.TagOffsets.push_back(Nodes.Tags.size());
+            ActiveNode = false;
+        } else if (element == "way" && ActiveWay) {
+            Map.WayIDs.push_back(ActiveWay->Identifier);
+            Map.WayIndex.Add(Map.WayIDs, Map.WayList.size());
+            ActiveWay->Tags.shrink_to_fit();
+            Map.WayList.push_back(ActiveWay);
+            ActiveWay = nullptr;
+        }
+    }
+};
+
+//builds the map from the nodes and ways of PBF blocks, the same way SParser does from the elements of an XML document
+struct COpenStreetMap::SImplementation::SPBFLoader : public COSMPBFReader::CHandler {
+    SImplementation &Map;
+    SStringPool &Strings;
+    SNodeStore &Nodes;
+
+    SPBFLoader(SImplementation &map) : Map(map), Strings(*map.Strings), Nodes(*map.Nodes) {
+    }
+
+    void Node(uint64_t id, double lat, double lon, const COSMPBFReader::TTags &tags) override {
+        Nodes.IDs.push_back(id);
+        Nodes.Latitudes.push_back(lat);
+        Nodes.Longitudes.push_back(lon);
+        for (auto &tag : tags) {
+            SetTag(Strings, Nodes.Tags, Nodes.TagOffsets.back(), tag.first, tag.second);
+        }
+        Map.NodeIndex.Add(Nodes.IDs, Nodes.IDs.size() - 1);
+        Nodes.TagOffsets.push_back(Nodes.Tags.size());
+    }
+
+    void Way(uint64_t id, const std::vector<uint64_t> &refs, const COSMPBFReader::TTags &tags) override {
+        auto way = std::make_shared<SWayData>();
+        way->Strings = Map.Strings;
+        way->Identifier = id;
+        way->NodeReferences = refs;
+        for (auto &tag : tags) {
+            SetTag(Strings, way->Tags, 0, tag.first, tag.second);
+        }
+        way->Tags.shrink_to_fit();
+        Map.WayIDs.push_back(id);
+        Map.WayIndex.Add(Map.WayIDs, Map.WayList.size());
+        Map.WayList.push_back(std::move(way));
+    }
+};
+
+//a piece of a document in memory as a data source, with the text that goes before and after it so the piece parses as
+//a document of its own. it lends its bytes, so the XML reader parses straight out of the document
+class COpenStreetMap::SImplementation::SChunkSource : public CDataSource {
+    std::array<std::string_view, 3> Parts;
+    std::size_t Part = 0;
+
+    void SkipEmpty() noexcept {
+        while (Part < Parts.size() && Parts[Part].empty()) {
+            Part++;
+        }
+    }
+
+public:
+    SChunkSource(std::string_view before, std::string_view text, std::string_view after) : Parts{before, text, after} {
+        SkipEmpty();
+    }
+
+    bool End() const noexcept override {
+        return Part == Parts.size();
+    }
+
+    bool Get(char &ch) noexcept override {
+        if (!Peek(ch)) {
+            return false;
+        }
+        Parts[Part].remove_prefix(1);
+        SkipEmpty();
+        return true;
+    }
+
+    bool Peek(char &ch) noexcept override {
+        if (End()) {
+            return false;
+        }
+        ch = Parts[Part].front();
+        return true;
+    }
+
+    bool Read(std::vector<char> &buf, std::size_t count) noexcept override {
+        std::string_view chunk;
+        buf.clear();
+        if (!Borrow(chunk, count)) {
+            return false;
+        }
+        buf.assign(chunk.begin(), chunk.end());
+        return true;
+    }
+
+    bool Borrow(std::string_view &chunk, std::size_t max) noexcept override {
+        if (End()) {
+            chunk = std::string_view();
+            return false;
+        }
+        chunk = Parts[Part].substr(0, max);
+        Parts[Part].remove_prefix(chunk.size());
+        SkipEmpty();
+        return true;
+    }
+};
+
+COpenStreetMap::SImplementation::SImplementation() : Strings(std::make_shared<SStringPool>()), Nodes(std::make_shared<SNodeStore>()) {
+    Nodes->Strings = Strings;
+}
+
+//false if the XML was bad, the map then has what was read before the error
+bool COpenStreetMap::SImplementation::Parse(CXMLReader &reader) {
+    SParser parser(*this);
+    bool valid = reader.Parse(parser);
+    parser.DropActiveNode();
+    return valid;
+}
+
+//decodes blocks first up to last in order, false at a damaged one, the map then has what came before the damage
+bool COpenStreetMap::SImplementation::Decode(const COSMPBFReader &reader, std::size_t first, std::size_t last) {
+    SPBFLoader loader(*this);
+    for (std::size_t block = first; block < last; block++) {
+        if (!reader.DecodeBlock(block, loader)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//the store is never added to after this, so give back the slack from the vectors doubling
+void COpenStreetMap::SImplementation::Finish() {
+    Nodes->IDs.shrink_to_fit();
+    Nodes->Latitudes.shrink_to_fit();
+    Nodes->Longitudes.shrink_to_fit();
+    Nodes->TagOffsets.shrink_to_fit();
+    Nodes->Tags.shrink_to_fit();
+}
+
+//0 threads means one per core
+std::size_t COpenStreetMap::SImplementation::ThreadCount(std::size_t threads) noexcept {
+    return threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+//the whole document in memory, sources that can lend all of it at once (string, mmap) arent copied at all
+std::string_view COpenStreetMap::SImplementation::ReadDocument(CDataSource &source, std::string &copy) {
+    const std::size_t BlockSize = 1 << 20;
+    std::string_view chunk;
+    copy.clear();
+    if (source.Borrow(chunk, std::numeric_limits<std::size_t>::max())) {
+        if (source.End()) {
+            return chunk;
+        }
+        copy.assign(chunk);
+    }
+    std::vector<char> block;
+    while (!source.End()) {
+        if (source.Borrow(chunk, BlockSize)) {
+            copy.append(chunk);
+        } else if (source.Read(block, BlockSize)) {
+            copy.append(block.data(), block.size());
+        } else {
+            break;
+        }
+    }
+    return copy;
+}
+
+//where to cut the document so each piece parses on its own, as offsets from 0 to the size. the cuts are only ever right
+//before a <node or <way, which in an OSM file are always children of the root. a document with comments, CDATA or a DTD
+//(anything starting "<!") could hide one of those in text, so it isnt split at all
+std::vector<std::size_t> COpenStreetMap::SImplementation::SplitDocument(std::string_view document, std::size_t threads) {
+    std::size_t count = std::min(ThreadCount(threads), document.size() / MinChunkSize);
+    std::vector<std::size_t> cuts = {0};
+    if (count > 1 && document.find("<!") == std::string_view::npos) {
+        auto elementStart = [document](std::size_t from) {
+            for (auto open = document.find('<', from); open != std::string_view::npos; open = document.find('<', open + 1)) {
+                for (std::string_view element : {"<node", "<way"}) {
+                    auto after = open + element.size();
+                    if (document.compare(open, element.size(), element) == 0 && after < document.size()
+                        && std::string_view(" \t\r\n/>").find(document[after]) != std::string_view::npos) {
+                        return open;
                     }
                 }
             }
-        } else if (xmlEntity.DType == SXMLEntity::EType::EndElement) {
-            if (xmlEntity.DNameData == "node" && activeNode) {
-                DImplementation->NodeList.push_back(activeNode);
-                activeNode = nullptr;
-            } else if (xmlEntity.DNameData == "way" && activeWay) {
-                DImplementation->WayList.push_back(activeWay);
-                activeWay = nullptr;
+            return document.size();
+        };
+        for (std::size_t piece = 1; piece < count; piece++) {
+            auto cut = elementStart(std::max(document.size() / count * piece, cuts.back() + 1));
+            if (cut >= document.size()) {
+                break;
+            }
+            cuts.push_back(cut);
+        }
+    }
+    cuts.push_back(document.size());
+    return cuts;
+}
+
+//appends a piece parsed on its own, in document order. its tag strings are interned into this pool in the order the
+//piece first used them, which is the order a single pass over the whole document would have given them
+void COpenStreetMap::SImplementation::Merge(SImplementation &part) {
+    std::vector<TSymbol> symbols(part.Strings->Size());
+    for (std::size_t symbol = 0; symbol < symbols.size(); symbol++) {
+        symbols[symbol] = Strings->Intern(part.Strings->String(TSymbol(symbol)));
+    }
+    auto remap = [&symbols](TTag tag) {
+        return TTag(symbols[tag.first], symbols[tag.second]);
+    };
+
+    auto &nodes = *Nodes;
+    auto &partNodes = *part.Nodes;
+    std::size_t tagBase = nodes.Tags.size();
+    for (std::size_t index = 0; index < partNodes.Count(); index++) {
+        nodes.IDs.push_back(partNodes.IDs[index]);
+        nodes.Latitudes.push_back(partNodes.Latitudes[index]);
+        nodes.Longitudes.push_back(partNodes.Longitudes[index]);
+        nodes.TagOffsets.push_back(tagBase + partNodes.TagOffsets[index + 1]);
+        NodeIndex.Add(nodes.IDs, nodes.IDs.size() - 1);
+    }
+    std::transform(partNodes.Tags.begin(), partNodes.Tags.end(), std::back_inserter(nodes.Tags), remap);
+
+    for (auto &way : part.WayList) {
+        way->Strings = Strings;
+        std::transform(way->Tags.begin(), way->Tags.end(), way->Tags.begin(), remap);
+        WayIDs.push_back(way->Identifier);
+        WayIndex.Add(WayIDs, WayList.size());
+        WayList.push_back(std::move(way));
+    }
+}
+
+COpenStreetMap::SFilter COpenStreetMap::SFilter::Routing() {
+    SFilter filter;
+    filter.Highways = {"motorway", "motorway_link", "trunk", "trunk_link", "primary", "primary_link", "secondary",
+                       "secondary_link", "tertiary", "tertiary_link", "unclassified", "residential", "living_street",
+                       "service", "road", "track", "pedestrian", "footway", "path", "cycleway", "bridleway", "steps"};
+    filter.WayTags = {"highway", "oneway", "maxspeed", "name"};
+    return filter;
+}
+
+//the counts of the map as it is, before and after both set to them
+COpenStreetMap::SFilterCounts COpenStreetMap::SImplementation::CurrentCounts() const noexcept {
+    SFilterCounts counts;
+    counts.NodesBefore = counts.NodesAfter = Nodes->Count();
+    counts.WaysBefore = counts.WaysAfter = WayList.size();
+    counts.TagsBefore = Nodes->Tags.size();
+    for (auto &way : WayList) {
+        counts.TagsBefore += way->Tags.size();
+    }
+    counts.TagsAfter = counts.TagsBefore;
+    counts.StringsBefore = counts.StringsAfter = Strings->Size();
+    return counts;
+}
+
+//rebuilds the map with only what filter keeps, into a new string pool so the strings nothing uses anymore go too.
+//its done once everything is loaded since an OSM file has its nodes before the ways that use them. a repeated node id
+//is kept once, NodeByID only ever found the first one
+void COpenStreetMap::SImplementation::Filter(const SFilter &filter) {
+    auto before = CurrentCounts();
+    auto findAll = [this](const std::vector<std::string> &strings) {
+        std::vector<TSymbol> symbols;
+        for (auto &str : strings) {
+            auto symbol = Strings->Find(str);
+            if (symbol != SStringPool::NotInterned) {
+                symbols.push_back(symbol);
+            }
+        }
+        return symbols;
+    };
+    auto contains = [](const std::vector<TSymbol> &symbols, TSymbol symbol) {
+        return std::find(symbols.begin(), symbols.end(), symbol) != symbols.end();
+    };
+    const auto highways = findAll(filter.Highways);
+    const auto wayKeys = findAll(filter.WayTags);
+    const auto nodeKeys = findAll(filter.NodeTags);
+
+    SImplementation filtered;
+    std::vector<TSymbol> symbols(Strings->Size(), SStringPool::NotInterned);
+    //interns into the new pool the first time an old symbol is used, in the order a load of the filtered file would
+    auto keepTags = [&](const TTag *begin, const TTag *end, const std::vector<TSymbol> &keys, std::vector<TTag> &tags) {
+        for (auto tag = begin; tag != end; tag++) {
+            if (contains(keys, tag->first)) {
+                for (auto symbol : {tag->first, tag->second}) {
+                    if (symbols[symbol] == SStringPool::NotInterned) {
+                        symbols[symbol] = filtered.Strings->Intern(Strings->String(symbol));
+                    }
+                }
+                tags.emplace_back(symbols[tag->first], symbols[tag->second]);
             }
         }
+    };
+
+    std::vector<char> keepNode(Nodes->Count(), false);
+    auto markNode = [&](TNodeID id) {
+        auto index = NodeIndex.Find(Nodes->IDs, id);
+        if (index != SIDIndex::NotFound) {
+            keepNode[index] = true;
+        }
+    };
+    std::vector<std::shared_ptr<SWayData>> ways;
+    for (auto &way : WayList) {
+        auto end = way->Tags.data() + way->Tags.size();
+        auto highway = FindTag(*Strings, way->Tags.data(), end, "highway");
+        if (highway != end && contains(highways, highway->second)) {
+            std::for_each(way->NodeReferences.begin(), way->NodeReferences.end(), markNode);
+            ways.push_back(way);
+        }
+    }
+    std::for_each(filter.Nodes.begin(), filter.Nodes.end(), markNode);
+
+    auto &nodes = *filtered.Nodes;
+    for (std::size_t index = 0; index < keepNode.size(); index++) {
+        if (keepNode[index]) {
+            nodes.IDs.push_back(Nodes->IDs[index]);
+            nodes.Latitudes.push_back(Nodes->Latitudes[index]);
+            nodes.Longitudes.push_back(Nodes->Longitudes[index]);
+            keepTags(Nodes->TagsBegin(index), Nodes->TagsEnd(index), nodeKeys, nodes.Tags);
+            nodes.TagOffsets.push_back(nodes.Tags.size());
+            filtered.NodeIndex.Add(nodes.IDs, nodes.IDs.size() - 1);
+        }
+    }
+    for (auto &way : ways) {
+        std::vector<TTag> tags;
+        keepTags(way->Tags.data(), way->Tags.data() + way->Tags.size(), wayKeys, tags);
+        tags.shrink_to_fit();
+        way->Tags.swap(tags);
+        way->Strings = filtered.Strings;
+        filtered.WayIDs.push_back(way->Identifier);
+        filtered.WayIndex.Add(filtered.WayIDs, filtered.WayList.size());
+        filtered.WayList.push_back(std::move(way));
+    }
+
+    *this = std::move(filtered);
+    Counts = CurrentCounts();
+    Counts.NodesBefore = before.NodesBefore;
+    Counts.WaysBefore = before.WaysBefore;
+    Counts.TagsBefore = before.TagsBefore;
+    Counts.StringsBefore = before.StringsBefore;
+    Filtered = true;
+}
+
+//PBF blocks are already pieces that decode on their own, so the blocks are just dealt out to the threads in runs that
+//keep file order and the parts merged like the XML pieces. a damaged block ends the map there, same as a single pass
+std::unique_ptr<COpenStreetMap::SImplementation> COpenStreetMap::SImplementation::LoadPBF(std::string_view document, std::size_t threads) {
+    COSMPBFReader reader(document);
+    const std::size_t blocks = reader.BlockCount();
+    const std::size_t count = std::max<std::size_t>(1, std::min(ThreadCount(threads), blocks));
+    std::vector<std::unique_ptr<SImplementation>> parts(count);
+    std::vector<char> valid(count, false);
+    std::vector<std::exception_ptr> errors(count);
+    auto decode = [&](std::size_t part) {
+        try {
+            parts[part] = std::make_unique<SImplementation>();
+            valid[part] = parts[part]->Decode(reader, blocks * part / count, blocks * (part + 1) / count);
+        } catch (...) {
+            errors[part] = std::current_exception();
+        }
+    };
+    if (count == 1) {
+        decode(0);
+    } else {
+        std::vector<std::thread> workers;
+        for (std::size_t part = 0; part < count; part++) {
+            workers.emplace_back(decode, part);
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    auto map = std::move(parts[0]);
+    for (std::size_t part = 1; part < count && valid[part - 1]; part++) {
+        map->Merge(*parts[part]);
+        parts[part].reset();
     }
+    return map;
+}
+
+//the whole map from an XML or PBF document, before Finish
+std::unique_ptr<COpenStreetMap::SImplementation> COpenStreetMap::SImplementation::Load(CDataSource &source, std::size_t threads) {
+    std::string copy;
+    std::string_view document = ReadDocument(source, copy);
+    if (COSMPBFReader::IsPBF(document)) {
+        return LoadPBF(document, threads);
+    }
+    auto cuts = SplitDocument(document, threads);
+    auto parseWhole = [&]() {
+        auto map = std::make_unique<SImplementation>();
+        CXMLReader reader(std::make_shared<SChunkSource>("", document, ""));
+        map->Parse(reader);
+        return map;
+    };
+    if (cuts.size() <= 2) {
+        return parseWhole();
+    }
+
+    //every piece but the first gets an opening root and every piece but the last a closing one
+    const std::size_t count = cuts.size() - 1;
+    std::vector<std::unique_ptr<SImplementation>> parts(count);
+    std::vector<char> valid(count, false);
+    std::vector<std::thread> workers;
+    for (std::size_t piece = 0; piece < count; piece++) {
+        workers.emplace_back([&, piece]() {
+            try {
+                parts[piece] = std::make_unique<SImplementation>();
+                CXMLReader reader(std::make_shared<SChunkSource>(piece ? "<osm>" : "", document.substr(cuts[piece], cuts[piece + 1] - cuts[piece]), piece + 1 < count ? "</osm>" : ""));
+                valid[piece] = parts[piece]->Parse(reader);
+            } catch (...) {
+                valid[piece] = false;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    //a piece that didnt parse means the cuts werent where they should be or the XML is bad, either way a single pass
+    //gives exactly what the XML reader constructor would (including its exceptions)
+    if (std::find(valid.begin(), valid.end(), false) != valid.end()) {
+        return parseWhole();
+    }
+    auto map = std::move(parts[0]);
+    for (std::size_t piece = 1; piece < count; piece++) {
+        map->Merge(*parts[piece]);
+        parts[piece].reset();
+    }
+    return map;
+}
+
+COpenStreetMap::COpenStreetMap(std::shared_ptr<CXMLReader> source) {
+    DImplementation = std::make_unique<SImplementation>();
+    DImplementation->Parse(*source);
+    DImplementation->Finish();
+}
+
+COpenStreetMap::COpenStreetMap(std::shared_ptr<CDataSource> source, std::size_t threads) {
+    DImplementation = SImplementation::Load(*source, threads);
+    DImplementation->Finish();
+}
+
+COpenStreetMap::COpenStreetMap(std::shared_ptr<CDataSource> source, const SFilter &filter, std::size_t threads) {
+    DImplementation = SImplementation::Load(*source, threads);
+    DImplementation->Filter(filter);
+    DImplementation->Finish();
 }
 
 COpenStreetMap::~COpenStreetMap() = default;
 
 std::size_t COpenStreetMap::NodeCount() const noexcept {
-    return DImplementation->NodeList.size();
+    return DImplementation->Nodes->Count();
 }
 
 std::size_t COpenStreetMap::WayCount() const noexcept {
@@ -176,16 +896,19 @@ std::size_t COpenStreetMap::WayCount() const noexcept {
 }
 
 std::shared_ptr<CStreetMap::SNode> COpenStreetMap::NodeByIndex(std::size_t index) const noexcept {
-    return (index < DImplementation->NodeList.size()) ? DImplementation->NodeList[index] : nullptr;
+    if (index >= DImplementation->Nodes->Count()) {
+        return nullptr;
+    }
+    try {
+        return std::make_shared<SImplementation::SNodeHandle>(DImplementation->Nodes, index);
+    } catch (...) {
+        return nullptr;
+    }
 }
 
 std::shared_ptr<CStreetMap::SNode> COpenStreetMap::NodeByID(TNodeID id) const noexcept {
-    for (const auto& node : DImplementation->NodeList) {
-        if (node->ID() == id) {
-            return node;
-        }
-    }
-    return nullptr;
+    auto index = DImplementation->NodeIndex.Find(DImplementation->Nodes->IDs, id);
+    return (index != SImplementation::SIDIndex::NotFound) ? NodeByIndex(index) : nullptr;
     //must return null
 }
 
@@ -194,11 +917,11 @@ std::shared_ptr<CStreetMap::SWay> COpenStreetMap::WayByIndex(std::size_t index)
 }
 
 std::shared_ptr<CStreetMap::SWay> COpenStreetMap::WayByID(TWayID id) const noexcept {
-    for (const auto& way : DImplementation->WayList) {
-        if (way->ID() == id) {
-            return way;
-        }
-    }
-    return nullptr;
+    auto index = DImplementation->WayIndex.Find(DImplementation->WayIDs, id);
+    return (index != SImplementation::SIDIndex::NotFound) ? DImplementation->WayList[index] : nullptr;
     //must return unull
-}
\ No newline at end of file
+}
+
+COpenStreetMap::SFilterCounts COpenStreetMap::FilterCounts() const noexcept {
+    return DImplementation->Filtered ? DImplementation->Counts : DImplementation->CurrentCounts();
+}
@@ -0,0 +1,33 @@
+#include "StandardDataSource.h"
+#include <iostream>
+
+bool CStandardDataSource::End() const noexcept{
+    return std::cin.eof() || (std::cin.peek() == EOF);
+}
+
+bool CStandardDataSource::Get(char &ch) noexcept{
+    int TempCh = std::cin.get();
+    if(TempCh == EOF){
+        return false;
+    }
+    ch = TempCh;
+    return true;
+}
+
+bool CStandardDataSource::Peek(char &ch) noexcept{
+    int TempCh = std::cin.peek();
+    if(TempCh == EOF){
+        return false;
+    }
+    ch = TempCh;
+    return true;
+}
+
+bool CStandardDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    char TempCh;
+    buf.clear();
+    while(buf.size() < count && Get(TempCh)){
+        buf.push_back(TempCh);
+    }
+    return !buf.empty();
+}
@@ -1,4 +1,5 @@
 #include "StringDataSource.h"
+#include <algorithm>
 
 CStringDataSource::CStringDataSource(const std::string &str) : DString(str), DIndex(0){
 
@@ -26,15 +27,15 @@ bool CStringDataSource::Peek(char &ch) noexcept{
 }
 
 bool CStringDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
-    buf.clear();
-    while(buf.size() < count){
-        char TempChar;
-        if(Get(TempChar)){
-            buf.push_back(TempChar);
-        }
-        else{
-            break;
-        }
-    }
+    // copy the whole run at once instead of a Get per character
+    std::size_t Count = std::min(count, DString.length() - std::min(DIndex, DString.length()));
+    buf.assign(DString.begin() + DIndex, DString.begin() + DIndex + Count);
+    DIndex += Count;
     return !buf.empty();
 }
+
+bool CStringDataSource::Borrow(std::string_view &chunk, std::size_t max) noexcept{
+    chunk = std::string_view(DString).substr(std::min(DIndex, DString.length()), max);
+    DIndex += chunk.size();
+    return !chunk.empty();
+}
@@ -1,4 +1,7 @@
 #include "StringUtils.h"
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
 
 namespace StringUtils
 {
@@ -290,4 +293,30 @@ namespace StringUtils
         // this is the distance between the two strings
         return distance[leftSize][rightSize];
     }
+
+    unsigned long long ParseUnsigned(std::string_view str)
+    {
+        while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front())))
+        {
+            str.remove_prefix(1);
+        }
+        bool negative = false;
+        if (!str.empty() && (str.front() == '+' || str.front() == '-'))
+        {
+            negative = str.front() == '-';
+            str.remove_prefix(1);
+        }
+        unsigned long long value;
+        auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+        if (result.ec == std::errc::invalid_argument)
+        {
+            throw std::invalid_argument("stoull");
+        }
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            throw std::out_of_range("stoull");
+        }
+        // same as stoull, a minus sign wraps the value around
+        return negative ? -value : value;
+    }
 };
\ No newline at end of file
@@ -3,21 +3,35 @@
 #include <expat.h>
 #include <queue>
 #include <vector>
+#include <string_view>
+#include <exception>
+#include <utility>
 
 struct CXMLReader::SImplementation {
     std::shared_ptr<CDataSource> Source;
     XML_Parser Parser;
     std::queue<SXMLEntity> EntityQueue;
     std::string CharBuffer;
+    // the source is read in chunks this big, each one goes to expat in a single XML_Parse call
+    // ReadBuffer only holds the chunk for sources that cant lend their bytes (see CDataSource::Borrow)
+    static constexpr size_t ChunkSize = 64 * 1024;
+    std::vector<char> ReadBuffer;
     bool IsEndOfData;
-
-    static void OnStartElement(void* userData, const char* name, const char** attrs) {
-        auto* impl = static_cast<SImplementation*>(userData);
-
-        if (!impl->CharBuffer.empty()) {
-            impl->EntityQueue.push({SXMLEntity::EType::CharData, impl->CharBuffer});
-            impl->CharBuffer.clear();
+    // where the expat callbacks go while Parse runs, null means they are queued up as entities for ReadEntity
+    CHandler* Handler = nullptr;
+    // an exception a handler threw, it cant unwind through expat so the parser is stopped and it is rethrown after
+    std::exception_ptr HandlerException;
+
+    // ReadEntity's side: the text between tags is gathered up and queued as one CharData entity
+    void QueueCharData() {
+        if (!CharBuffer.empty()) {
+            EntityQueue.push({SXMLEntity::EType::CharData, std::move(CharBuffer)});
+            CharBuffer.clear();
         }
+    }
+
+    void QueueStartElement(const char* name, const char** attrs) {
+        QueueCharData();
 
         SXMLEntity entity;
         entity.DType = SXMLEntity::EType::StartElement;
@@ -29,25 +43,44 @@ struct CXMLReader::SImplementation {
             }
         }
 
-        impl->EntityQueue.push(entity);
+        EntityQueue.push(std::move(entity));
     }
 
-    static void OnEndElement(void* userData, const char* name) {
-        auto* impl = static_cast<SImplementation*>(userData);
+    void QueueEndElement(const char* name) {
+        QueueCharData();
+        EntityQueue.push({SXMLEntity::EType::EndElement, name});
+    }
 
-        if (!impl->CharBuffer.empty()) {
-            impl->EntityQueue.push({SXMLEntity::EType::CharData, impl->CharBuffer});
-            impl->CharBuffer.clear();
+    // runs a handler call, catching what it throws so expat never has to unwind
+    template <typename TCall> static void Dispatch(void* userData, TCall call) {
+        auto* impl = static_cast<SImplementation*>(userData);
+        try {
+            call(impl);
+        } catch (...) {
+            impl->HandlerException = std::current_exception();
+            XML_StopParser(impl->Parser, XML_FALSE);
         }
+    }
 
-        impl->EntityQueue.push({SXMLEntity::EType::EndElement, name});
+    static void OnStartElement(void* userData, const char* name, const char** attrs) {
+        Dispatch(userData, [=](SImplementation* impl) {
+            impl->Handler ? impl->Handler->StartElement(name, attrs) : impl->QueueStartElement(name, attrs);
+        });
+    }
+
+    static void OnEndElement(void* userData, const char* name) {
+        Dispatch(userData, [=](SImplementation* impl) {
+            impl->Handler ? impl->Handler->EndElement(name) : impl->QueueEndElement(name);
+        });
     }
 
     static void OnCharacterData(void* userData, const char* data, int len) {
-        auto* impl = static_cast<SImplementation*>(userData);
-        if (data && len > 0) {
-            impl->CharBuffer.append(data, len);
+        if (!data || len <= 0) {
+            return;
         }
+        Dispatch(userData, [=](SImplementation* impl) {
+            impl->Handler ? impl->Handler->CharacterData(data, size_t(len)) : void(impl->CharBuffer.append(data, len));
+        });
     }
 
     explicit SImplementation(std::shared_ptr<CDataSource> src)
@@ -62,49 +95,76 @@ struct CXMLReader::SImplementation {
         XML_ParserFree(Parser);
     }
 
-    bool FetchEntity(SXMLEntity& entity, bool skipCharData = false) {
-        if (!EntityQueue.empty()) {
-            entity = EntityQueue.front();
-            EntityQueue.pop();
-
-            return skipCharData && entity.DType == SXMLEntity::EType::CharData
-                       ? FetchEntity(entity, skipCharData)
-                       : true;
-        }
-
-        std::vector<char> buffer(4096);
-        while (!IsEndOfData && EntityQueue.empty()) {
-            size_t bytesRead = 0;
-
-            while (bytesRead < buffer.size() && !Source->End()) {
-                char ch;
-                if (Source->Get(ch)) {
-                    buffer[bytesRead++] = ch;
-                } else {
-                    break;
-                }
-            }
-
-            if (bytesRead == 0) {
+    // hands the next chunk of the source to expat, false at the end of the data or if it isnt valid XML.
+    // rethrows anything a handler threw while it was being parsed
+    bool ParseChunk() {
+        // parse straight out of the source's memory when it can lend it, otherwise out of a copy
+        std::string_view chunk;
+        if (!Source->Borrow(chunk, ChunkSize)) {
+            if (!Source->Read(ReadBuffer, ChunkSize)) {
                 IsEndOfData = true;
                 return false;
             }
+            chunk = std::string_view(ReadBuffer.data(), ReadBuffer.size());
+        }
 
-            if (XML_Parse(Parser, buffer.data(), bytesRead, bytesRead == 0) == XML_STATUS_ERROR) {
+        auto status = XML_Parse(Parser, chunk.data(), chunk.size(), false);
+        if (HandlerException) {
+            std::rethrow_exception(std::exchange(HandlerException, nullptr));
+        }
+        return status != XML_STATUS_ERROR;
+    }
+
+    bool FetchEntity(SXMLEntity& entity, bool skipCharData = false) {
+        while (EntityQueue.empty()) {
+            if (IsEndOfData || !ParseChunk()) {
                 return false;
             }
+        }
+
+        entity = std::move(EntityQueue.front());
+        EntityQueue.pop();
 
-            if (!EntityQueue.empty()) {
-                entity = EntityQueue.front();
-                EntityQueue.pop();
+        return skipCharData && entity.DType == SXMLEntity::EType::CharData
+                   ? FetchEntity(entity, skipCharData)
+                   : true;
+    }
 
-                return skipCharData && entity.DType == SXMLEntity::EType::CharData
-                           ? FetchEntity(entity, skipCharData)
-                           : true;
+    bool Parse(CHandler& handler) {
+        // anything ReadEntity already parsed goes out first so the handler still sees the whole document
+        std::vector<const char*> attributes;
+        for (; !EntityQueue.empty(); EntityQueue.pop()) {
+            auto& entity = EntityQueue.front();
+            if (entity.DType == SXMLEntity::EType::StartElement) {
+                attributes.clear();
+                for (auto& attribute : entity.DAttributes) {
+                    attributes.push_back(attribute.first.c_str());
+                    attributes.push_back(attribute.second.c_str());
+                }
+                attributes.push_back(nullptr);
+                handler.StartElement(entity.DNameData.c_str(), attributes.data());
+            } else if (entity.DType == SXMLEntity::EType::EndElement) {
+                handler.EndElement(entity.DNameData.c_str());
+            } else {
+                handler.CharacterData(entity.DNameData.data(), entity.DNameData.size());
             }
         }
+        if (!CharBuffer.empty()) {
+            handler.CharacterData(CharBuffer.data(), CharBuffer.size());
+            CharBuffer.clear();
+        }
 
-        return false;
+        struct SHandlerScope {
+            CHandler*& Current;
+            ~SHandlerScope() { Current = nullptr; }
+        } scope{Handler};
+        Handler = &handler;
+        while (!IsEndOfData) {
+            if (!ParseChunk()) {
+                return IsEndOfData;
+            }
+        }
+        return true;
     }
 };
 
@@ -120,3 +180,7 @@ bool CXMLReader::End() const {
 bool CXMLReader::ReadEntity(SXMLEntity& entity, bool skipCharData) {
     return DImplementation->FetchEntity(entity, skipCharData);
 }
+
+bool CXMLReader::Parse(CHandler& handler) {
+    return DImplementation->Parse(handler);
+}
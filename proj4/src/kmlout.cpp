@@ -13,6 +13,7 @@
 #include <iostream>
 #include <unordered_set>
 #include <unordered_map>
+#include <string_view>
 
 class CArgumentParser{
     private:
@@ -163,9 +164,10 @@ CKMLTranslator::CKMLTranslator(std::shared_ptr<CStreetMap> map, std::shared_ptr<
         if((StopIDIndex >= TempRow.size())||(NodeIDIndex >= TempRow.size())){
             throw std::runtime_error("Missing stops header!");
         }
-        while(stops->ReadRow(TempRow)){
-            auto StopID = std::stoull(TempRow[StopIDIndex]);
-            auto NodeID = std::stoull(TempRow[NodeIDIndex]);
+        std::vector<std::string_view> Row;
+        while(stops->ReadRowView(Row)){
+            auto StopID = StringUtils::ParseUnsigned(Row[StopIDIndex]);
+            auto NodeID = StringUtils::ParseUnsigned(Row[NodeIDIndex]);
             DNodeIDToStopID[NodeID] = StopID;
         }
     }
@@ -191,16 +193,19 @@ CKMLTranslator::CKMLTranslator(std::shared_ptr<CStreetMap> map, std::shared_ptr<
         if((SourceIDIndex >= TempRow.size())||(DestinationIDIndex >= TempRow.size())||(RoutesIndex >= TempRow.size())||(PathIndex >= TempRow.size())){
             throw std::runtime_error("Missing buspath header!");
         }
-        while(buspaths->ReadRow(TempRow)){
-            auto SourceID = std::stoull(TempRow[SourceIDIndex]);
-            auto DestinationID = std::stoull(TempRow[DestinationIDIndex]);
-            auto Routes = StringUtils::Split(TempRow[RoutesIndex],"_");
-            auto PathStrings = StringUtils::Split(TempRow[PathIndex],",");
+        std::vector<std::string_view> Row;
+        while(buspaths->ReadRowView(Row)){
+            auto SourceID = StringUtils::ParseUnsigned(Row[SourceIDIndex]);
+            auto DestinationID = StringUtils::ParseUnsigned(Row[DestinationIDIndex]);
+            // the path is a long comma separated list, walk it in place instead of splitting it into strings
+            std::string_view PathNodes = Row[PathIndex];
             std::vector<CStreetMap::TLocation> LocationList;
-            for(auto &NodeIDString : PathStrings){
-                auto NodeID = std::stoull(NodeIDString);
+            while(!PathNodes.empty()){
+                auto Comma = std::min(PathNodes.find(','), PathNodes.size());
+                auto NodeID = StringUtils::ParseUnsigned(PathNodes.substr(0, Comma));
                 auto Node = map->NodeByID(NodeID);
                 LocationList.push_back(Node->Location());
+                PathNodes.remove_prefix(std::min(Comma + 1, PathNodes.size()));
             }
             DBusSegmentToLocations[std::make_pair(SourceID,DestinationID)] = LocationList;
         }
@@ -303,9 +308,10 @@ std::vector<std::pair<std::string,CStreetMap::TNodeID> > CKMLTranslator::ParsePa
             return {};
         }
         std::vector<std::pair<std::string,CStreetMap::TNodeID> > ReturnVector;
-        while(path->ReadRow(TempRow)){
-            auto Mode = TempRow[ModeIndex];
-            auto NodeID = std::stoull(TempRow[NodeIDIndex]);
+        std::vector<std::string_view> Row;
+        while(path->ReadRowView(Row)){
+            auto Mode = std::string(Row[ModeIndex]);
+            auto NodeID = StringUtils::ParseUnsigned(Row[NodeIDIndex]);
             ReturnVector.push_back(std::make_pair(Mode,NodeID));
         }
         return ReturnVector;
@@ -0,0 +1,115 @@
+#include "TransportationPlannerConfig.h"
+#include "DijkstraTransportationPlanner.h"
+#include "OpenStreetMap.h"
+#include "CSVBusSystem.h"
+#include "FileDataFactory.h"
+#include "StringUtils.h"
+#include <iostream>
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+#include <cmath>
+
+// Times the distance/time table APIs of CDijkstraTransportationPlanner between the stops in stops.csv.
+// Syntax: matrixbench [--data=path | --precompute=seconds] [numstops]
+// numstops limits the table to the first numstops distinct stop nodes, 0 (the default) uses all of them.
+
+static std::size_t CountMismatches(const std::vector< std::vector< double > > &table, const std::vector< std::vector< double > > &reference){
+    std::size_t Mismatches = 0;
+    for(std::size_t Row = 0; Row < table.size(); Row++){
+        for(std::size_t Col = 0; Col < table[Row].size(); Col++){
+            double Expected = reference[Row][Col];
+            double Actual = table[Row][Col];
+            if((Expected == CPathRouter::NoPathExists) != (Actual == CPathRouter::NoPathExists)){
+                Mismatches++;
+            }
+            else if(Expected != CPathRouter::NoPathExists && std::fabs(Expected - Actual) > 1e-9 * (1 + Expected)){
+                Mismatches++;
+            }
+        }
+    }
+    return Mismatches;
+}
+
+static void Report(const std::string &name, std::chrono::steady_clock::time_point start, std::size_t entries, const std::string &extra = ""){
+    auto Duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::cout<<name<<": "<<Duration.count() / 1000.0<<" ms for "<<entries<<" entries";
+    std::cout<<" ("<<double(Duration.count()) / entries<<" us/entry)"<<extra<<"\n";
+}
+
+int main(int argc, char *argv[]){
+    std::string DataDirectory = "./data";
+    int PrecomputeTime = 30;
+    std::size_t NumStops = 0;
+    for(int Index = 1; Index < argc; Index++){
+        std::string Argument = argv[Index];
+        auto SplitArg = StringUtils::Split(Argument,"=");
+        if(SplitArg.size() == 2 && SplitArg[0] == "--data"){
+            DataDirectory = SplitArg[1];
+        }
+        else if(SplitArg.size() == 2 && SplitArg[0] == "--precompute"){
+            PrecomputeTime = std::stoi(SplitArg[1]);
+        }
+        else if(Argument.find("--") != 0){
+            NumStops = std::stoull(Argument);
+        }
+        else{
+            std::cerr<<"Syntax Error: matrixbench [--data=path | --precompute=seconds] [numstops]"<<std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto DataFactory = std::make_shared<CFileDataFactory>(DataDirectory);
+    auto StopReader = std::make_shared<CDSVReader>(DataFactory->CreateSource("stops.csv"),',');
+    auto RouteReader = std::make_shared<CDSVReader>(DataFactory->CreateSource("routes.csv"),',');
+    auto BusSystem = std::make_shared<CCSVBusSystem>(StopReader, RouteReader);
+    auto StreetMap = std::make_shared<COpenStreetMap>(std::make_shared<CXMLReader>(DataFactory->CreateSource("city.osm")));
+    auto Config = std::make_shared<STransportationPlannerConfig>(StreetMap, BusSystem, 3.0, 8.0, 25.0, 30.0, PrecomputeTime);
+    CDijkstraTransportationPlanner Planner(Config);
+
+    // several stops can share a node, the table only needs each node once
+    std::vector< CTransportationPlanner::TNodeID > Stops;
+    std::unordered_set< CTransportationPlanner::TNodeID > Seen;
+    for(std::size_t Index = 0; Index < BusSystem->StopCount(); Index++){
+        auto NodeID = BusSystem->StopByIndex(Index)->NodeID();
+        if(Seen.insert(NodeID).second && (!NumStops || Stops.size() < NumStops)){
+            Stops.push_back(NodeID);
+        }
+    }
+    std::size_t Entries = Stops.size() * Stops.size();
+    std::cout<<"Stops: "<<Stops.size()<<"\n";
+
+    std::vector< std::vector< double > > Pairwise(Stops.size(), std::vector< double >(Stops.size()));
+    std::vector< CTransportationPlanner::TNodeID > Path;
+    auto Start = std::chrono::steady_clock::now();
+    for(std::size_t Row = 0; Row < Stops.size(); Row++){
+        for(std::size_t Col = 0; Col < Stops.size(); Col++){
+            Pairwise[Row][Col] = Planner.FindShortestPath(Stops[Row], Stops[Col], Path);
+        }
+    }
+    Report("Distance, FindShortestPath per pair", Start, Entries);
+
+    std::vector< std::vector< double > > OneToMany;
+    Start = std::chrono::steady_clock::now();
+    for(auto Source : Stops){
+        OneToMany.push_back(Planner.FindShortestDistances(Source, Stops));
+    }
+    Report("Distance, FindShortestDistances per source", Start, Entries, ", " + std::to_string(CountMismatches(OneToMany, Pairwise)) + " mismatches");
+
+    Start = std::chrono::steady_clock::now();
+    auto Matrix = Planner.FindShortestDistanceMatrix(Stops, Stops);
+    Report("Distance, FindShortestDistanceMatrix", Start, Entries, ", " + std::to_string(CountMismatches(Matrix, Pairwise)) + " mismatches");
+
+    // FindFastestPath also works out the modes along the path, so the time tables are checked against each other
+    OneToMany.clear();
+    Start = std::chrono::steady_clock::now();
+    for(auto Source : Stops){
+        OneToMany.push_back(Planner.FindFastestTimes(Source, Stops));
+    }
+    Report("Time, FindFastestTimes per source", Start, Entries);
+
+    Start = std::chrono::steady_clock::now();
+    Matrix = Planner.FindFastestTimeMatrix(Stops, Stops);
+    Report("Time, FindFastestTimeMatrix", Start, Entries, ", " + std::to_string(CountMismatches(Matrix, OneToMany)) + " mismatches");
+    return EXIT_SUCCESS;
+}
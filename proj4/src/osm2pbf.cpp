@@ -0,0 +1,328 @@
+#include "XMLReader.h"
+#include "FileDataSource.h"
+#include "FileDataSink.h"
+#include <zlib.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+
+// Writes an .osm.pbf with the nodes and ways of an .osm file, in the same order. This is how data/city.osm.pbf is
+// made (make citypbf), so the nodes go in every block kind COSMPBFReader reads: dense nodes in zlib blobs of
+// NodesPerBlock, the nodes left over as plain Node messages in a raw blob, then the ways in zlib blobs.
+// Syntax: osm2pbf input.osm output.osm.pbf
+
+static constexpr std::size_t NodesPerBlock = 8000;
+static constexpr std::size_t WaysPerBlock = 8000;
+// lat/lon are stored in units of granularity nanodegrees, 100 is enough for the 7 decimals osm uses
+static constexpr int64_t Granularity = 100;
+static constexpr int CoordinateDecimals = 7;
+
+using TTags = std::vector< std::pair< std::string, std::string > >;
+
+struct SNode{
+    int64_t DID;
+    int64_t DLat;
+    int64_t DLon;
+    TTags DTags;
+};
+
+struct SWay{
+    int64_t DID;
+    std::vector< int64_t > DRefs;
+    TTags DTags;
+};
+
+static void AppendVarint(std::string &out, uint64_t value){
+    while(value >= 0x80){
+        out.push_back(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+static uint64_t ZigZag(int64_t value){
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+static void AppendVarintField(std::string &out, uint32_t field, uint64_t value){
+    AppendVarint(out, (field << 3) | 0);
+    AppendVarint(out, value);
+}
+
+static void AppendBytesField(std::string &out, uint32_t field, const std::string &bytes){
+    AppendVarint(out, (field << 3) | 2);
+    AppendVarint(out, bytes.size());
+    out += bytes;
+}
+
+static void AppendPackedField(std::string &out, uint32_t field, const std::vector< uint64_t > &values){
+    std::string Packed;
+    for(auto Value : values){
+        AppendVarint(Packed, Value);
+    }
+    AppendBytesField(out, field, Packed);
+}
+
+// the block's string table, index 0 is always the empty string
+class CStringTable{
+    private:
+        std::vector< std::string > DStrings = {""};
+        std::unordered_map< std::string, uint64_t > DIndices = {{"", 0}};
+    public:
+        uint64_t operator()(const std::string &str){
+            auto Search = DIndices.find(str);
+            if(Search != DIndices.end()){
+                return Search->second;
+            }
+            DIndices[str] = DStrings.size();
+            DStrings.push_back(str);
+            return DStrings.size() - 1;
+        }
+
+        std::string Encode() const{
+            std::string Table;
+            for(auto &String : DStrings){
+                AppendBytesField(Table, 1, String);
+            }
+            std::string Result;
+            AppendBytesField(Result, 1, Table);
+            return Result;
+        }
+};
+
+// a decimal degree string in granularity units, exactly, false if it has more decimals than that can hold
+static bool ParseCoordinate(const std::string &text, int64_t &value){
+    std::size_t Index = 0;
+    bool Negative = false;
+    if(Index < text.size() && (text[Index] == '-' || text[Index] == '+')){
+        Negative = text[Index++] == '-';
+    }
+    int64_t Result = 0;
+    int Decimals = -1;
+    bool Digits = false;
+    for(; Index < text.size(); Index++){
+        if(text[Index] == '.' && Decimals < 0){
+            Decimals = 0;
+        }
+        else if(text[Index] >= '0' && text[Index] <= '9'){
+            Digits = true;
+            if(Decimals >= CoordinateDecimals){
+                if(text[Index] != '0'){
+                    return false;
+                }
+                continue;
+            }
+            Result = Result * 10 + (text[Index] - '0');
+            if(Decimals >= 0){
+                Decimals++;
+            }
+        }
+        else{
+            return false;
+        }
+    }
+    for(Decimals = Decimals < 0 ? 0 : Decimals; Decimals < CoordinateDecimals; Decimals++){
+        Result *= 10;
+    }
+    value = Negative ? -Result : Result;
+    return Digits;
+}
+
+static std::string Blob(const std::string &type, const std::string &data, bool compress){
+    std::string Body;
+    if(compress){
+        uLongf Length = compressBound(data.size());
+        std::string Compressed(Length, '\0');
+        if(compress2(reinterpret_cast<Bytef *>(Compressed.data()), &Length, reinterpret_cast<const Bytef *>(data.data()), data.size(), 9) != Z_OK){
+            throw std::runtime_error("compress failed");
+        }
+        Compressed.resize(Length);
+        AppendVarintField(Body, 2, data.size());
+        AppendBytesField(Body, 3, Compressed);
+    }
+    else{
+        AppendBytesField(Body, 1, data);
+    }
+    std::string Header;
+    AppendBytesField(Header, 1, type);
+    AppendVarintField(Header, 3, Body.size());
+    std::string Result;
+    for(int Shift = 24; Shift >= 0; Shift -= 8){
+        Result.push_back(char((Header.size() >> Shift) & 0xFF));
+    }
+    return Result + Header + Body;
+}
+
+// a PrimitiveBlock around one group, the group has to be made first since it fills the string table
+static std::string Block(const CStringTable &strings, const std::string &group){
+    std::string Result = strings.Encode();
+    AppendBytesField(Result, 2, group);
+    AppendVarintField(Result, 17, Granularity);
+    return Result;
+}
+
+static void AppendTags(std::string &out, CStringTable &strings, const TTags &tags){
+    if(tags.empty()){
+        return;
+    }
+    std::vector< uint64_t > Keys, Values;
+    for(auto &Tag : tags){
+        Keys.push_back(strings(Tag.first));
+    }
+    for(auto &Tag : tags){
+        Values.push_back(strings(Tag.second));
+    }
+    AppendPackedField(out, 2, Keys);
+    AppendPackedField(out, 3, Values);
+}
+
+static std::string DenseNodeBlock(std::vector< SNode >::const_iterator begin, std::vector< SNode >::const_iterator end){
+    CStringTable Strings;
+    std::vector< uint64_t > IDs, Lats, Lons, KeysVals;
+    SNode Previous{0, 0, 0, {}};
+    bool AnyTags = false;
+    for(auto Node = begin; Node != end; ++Node){
+        IDs.push_back(ZigZag(Node->DID - Previous.DID));
+        Lats.push_back(ZigZag(Node->DLat - Previous.DLat));
+        Lons.push_back(ZigZag(Node->DLon - Previous.DLon));
+        Previous = *Node;
+        for(auto &Tag : Node->DTags){
+            KeysVals.push_back(Strings(Tag.first));
+            KeysVals.push_back(Strings(Tag.second));
+            AnyTags = true;
+        }
+        KeysVals.push_back(0);
+    }
+    std::string Dense, Group;
+    AppendPackedField(Dense, 1, IDs);
+    AppendPackedField(Dense, 8, Lats);
+    AppendPackedField(Dense, 9, Lons);
+    if(AnyTags){
+        AppendPackedField(Dense, 10, KeysVals);
+    }
+    AppendBytesField(Group, 2, Dense);
+    return Block(Strings, Group);
+}
+
+static std::string PlainNodeBlock(std::vector< SNode >::const_iterator begin, std::vector< SNode >::const_iterator end){
+    CStringTable Strings;
+    std::string Group;
+    for(auto Node = begin; Node != end; ++Node){
+        std::string Message;
+        AppendVarintField(Message, 1, ZigZag(Node->DID));
+        AppendTags(Message, Strings, Node->DTags);
+        AppendVarintField(Message, 8, ZigZag(Node->DLat));
+        AppendVarintField(Message, 9, ZigZag(Node->DLon));
+        AppendBytesField(Group, 1, Message);
+    }
+    return Block(Strings, Group);
+}
+
+static std::string WayBlock(std::vector< SWay >::const_iterator begin, std::vector< SWay >::const_iterator end){
+    CStringTable Strings;
+    std::string Group;
+    for(auto Way = begin; Way != end; ++Way){
+        std::string Message;
+        AppendVarintField(Message, 1, uint64_t(Way->DID));
+        AppendTags(Message, Strings, Way->DTags);
+        std::vector< uint64_t > Refs;
+        int64_t Previous = 0;
+        for(auto Ref : Way->DRefs){
+            Refs.push_back(ZigZag(Ref - Previous));
+            Previous = Ref;
+        }
+        AppendPackedField(Message, 8, Refs);
+        AppendBytesField(Group, 3, Message);
+    }
+    return Block(Strings, Group);
+}
+
+// the top level nodes and ways of the osm file, false if it isnt readable
+static bool ReadOSM(const std::string &filename, std::vector< SNode > &nodes, std::vector< SWay > &ways){
+    CXMLReader Reader(std::make_shared< CFileDataSource >(filename));
+    SXMLEntity Entity;
+    int Depth = 0;
+    SNode Node;
+    SWay Way;
+    std::string Current;
+    while(Reader.ReadEntity(Entity, true)){
+        if(Entity.DType == SXMLEntity::EType::StartElement){
+            Depth++;
+            if(Depth == 2 && Entity.DNameData == "node"){
+                Current = "node";
+                Node = SNode{std::stoll(Entity.AttributeValue("id")), 0, 0, {}};
+                if(!ParseCoordinate(Entity.AttributeValue("lat"), Node.DLat) || !ParseCoordinate(Entity.AttributeValue("lon"), Node.DLon)){
+                    std::cerr<<"node "<<Node.DID<<" has a location that doesnt fit the granularity"<<std::endl;
+                    return false;
+                }
+            }
+            else if(Depth == 2 && Entity.DNameData == "way"){
+                Current = "way";
+                Way = SWay{std::stoll(Entity.AttributeValue("id")), {}, {}};
+            }
+            else if(Depth == 3 && Entity.DNameData == "tag"){
+                auto &Tags = Current == "node" ? Node.DTags : Way.DTags;
+                if(!Current.empty()){
+                    Tags.push_back({Entity.AttributeValue("k"), Entity.AttributeValue("v")});
+                }
+            }
+            else if(Depth == 3 && Entity.DNameData == "nd" && Current == "way"){
+                Way.DRefs.push_back(std::stoll(Entity.AttributeValue("ref")));
+            }
+        }
+        else if(Entity.DType == SXMLEntity::EType::EndElement){
+            if(Depth == 2 && Current == "node"){
+                nodes.push_back(Node);
+            }
+            else if(Depth == 2 && Current == "way"){
+                ways.push_back(Way);
+            }
+            if(Depth == 2){
+                Current.clear();
+            }
+            Depth--;
+        }
+    }
+    return Reader.End() && Depth == 0;
+}
+
+int main(int argc, char *argv[]){
+    if(argc != 3){
+        std::cerr<<"Syntax Error: osm2pbf input.osm output.osm.pbf"<<std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector< SNode > Nodes;
+    std::vector< SWay > Ways;
+    if(!ReadOSM(argv[1], Nodes, Ways)){
+        std::cerr<<"Failed to read "<<argv[1]<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string HeaderBlock, Output;
+    AppendBytesField(HeaderBlock, 4, "OsmSchema-V0.6");
+    AppendBytesField(HeaderBlock, 4, "DenseNodes");
+    AppendBytesField(HeaderBlock, 16, "osm2pbf");
+    Output = Blob("OSMHeader", HeaderBlock, true);
+    std::size_t DenseCount = Nodes.size() / NodesPerBlock * NodesPerBlock;
+    for(std::size_t Index = 0; Index < DenseCount; Index += NodesPerBlock){
+        Output += Blob("OSMData", DenseNodeBlock(Nodes.begin() + Index, Nodes.begin() + Index + NodesPerBlock), true);
+    }
+    Output += Blob("OSMData", PlainNodeBlock(Nodes.begin() + DenseCount, Nodes.end()), false);
+    for(std::size_t Index = 0; Index < Ways.size(); Index += WaysPerBlock){
+        Output += Blob("OSMData", WayBlock(Ways.begin() + Index, Ways.begin() + std::min(Index + WaysPerBlock, Ways.size())), true);
+    }
+
+    CFileDataSink Sink(argv[2]);
+    if(!Sink.Write(std::vector< char >(Output.begin(), Output.end()))){
+        std::cerr<<"Failed to write "<<argv[2]<<std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout<<Nodes.size()<<" nodes and "<<Ways.size()<<" ways written to "<<argv[2]<<std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "DijkstraPathRouter.h"
+#include "OpenStreetMap.h"
+#include "FileDataFactory.h"
+#include "GeographicUtils.h"
+#include "StringUtils.h"
+#include <iostream>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include <cmath>
+
+// Compares the CDijkstraPathRouter queue policies on the street graph of city.osm.
+// Syntax: routerbench [--data=path | --seed=rngseed] [numqueries]
+
+struct SQueueBenchmark{
+    std::string DName;
+    CDijkstraPathRouter::EQueuePolicy DPolicy;
+};
+
+// Builds the same distance graph as CDijkstraTransportationPlanner (haversine edges, oneway respected)
+static void BuildStreetGraph(std::shared_ptr<CStreetMap> streetmap, CDijkstraPathRouter &router){
+    std::unordered_map<CStreetMap::TNodeID, CPathRouter::TVertexID> NodeIDToVertexID;
+    std::unordered_map<CStreetMap::TNodeID, CStreetMap::TLocation> NodeIDToLocation;
+    for(std::size_t Index = 0; Index < streetmap->NodeCount(); Index++){
+        auto Node = streetmap->NodeByIndex(Index);
+        NodeIDToVertexID[Node->ID()] = router.AddVertex(Node->ID());
+        NodeIDToLocation[Node->ID()] = Node->Location();
+    }
+    for(std::size_t Index = 0; Index < streetmap->WayCount(); Index++){
+        auto Way = streetmap->WayByIndex(Index);
+        bool Oneway = Way->GetAttribute("oneway") == "yes" || Way->GetAttribute("oneway") == "1";
+        for(std::size_t NodeIndex = 1; NodeIndex < Way->NodeCount(); NodeIndex++){
+            auto Source = NodeIDToVertexID.find(Way->GetNodeID(NodeIndex - 1));
+            auto Dest = NodeIDToVertexID.find(Way->GetNodeID(NodeIndex));
+            if(Source == NodeIDToVertexID.end() || Dest == NodeIDToVertexID.end()){
+                continue;
+            }
+            double Distance = SGeographicUtils::HaversineDistanceInMiles(NodeIDToLocation[Source->first], NodeIDToLocation[Dest->first]);
+            router.AddEdge(Source->second, Dest->second, Distance, !Oneway);
+        }
+    }
+}
+
+int main(int argc, char *argv[]){
+    std::string DataDirectory = "./data";
+    uint64_t Seed = 1234;
+    uint64_t NumQueries = 1000;
+    for(int Index = 1; Index < argc; Index++){
+        std::string Argument = argv[Index];
+        auto SplitArg = StringUtils::Split(Argument,"=");
+        if(SplitArg.size() == 2 && SplitArg[0] == "--data"){
+            DataDirectory = SplitArg[1];
+        }
+        else if(SplitArg.size() == 2 && SplitArg[0] == "--seed"){
+            Seed = std::stoull(SplitArg[1]);
+        }
+        else if(Argument.find("--") != 0){
+            NumQueries = std::stoull(Argument);
+        }
+        else{
+            std::cerr<<"Syntax Error: routerbench [--data=path | --seed=rngseed] [numqueries]"<<std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto DataFactory = std::make_shared<CFileDataFactory>(DataDirectory);
+    auto StreetMap = std::make_shared<COpenStreetMap>(std::make_shared<CXMLReader>(DataFactory->CreateSource("city.osm")));
+    CDijkstraPathRouter Router;
+    BuildStreetGraph(StreetMap, Router);
+    Router.Precompute(std::chrono::steady_clock::now() + std::chrono::seconds(30));
+    std::cout<<"Vertices: "<<Router.VertexCount()<<"\n";
+
+    std::vector< std::pair< CPathRouter::TVertexID, CPathRouter::TVertexID > > Queries;
+    srand(Seed);
+    for(uint64_t Index = 0; Index < NumQueries; Index++){
+        Queries.push_back(std::make_pair(rand() % Router.VertexCount(), rand() % Router.VertexCount()));
+    }
+
+    std::vector<SQueueBenchmark> Benchmarks = {
+        {"Binary heap (lazy)", CDijkstraPathRouter::EQueuePolicy::BinaryHeap},
+        {"4-ary heap (decrease-key)", CDijkstraPathRouter::EQueuePolicy::QuaternaryHeap},
+        {"Radix heap", CDijkstraPathRouter::EQueuePolicy::RadixHeap}
+    };
+    std::vector<double> Reference;
+    std::vector<CPathRouter::TVertexID> Path;
+    for(auto &Benchmark : Benchmarks){
+        Router.SetQueuePolicy(Benchmark.DPolicy);
+        std::vector<double> Distances;
+        auto Start = std::chrono::steady_clock::now();
+        for(auto &Query : Queries){
+            Distances.push_back(Router.FindShortestPath(Query.first, Query.second, Path));
+        }
+        auto Duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start);
+        std::size_t Mismatches = 0;
+        if(Reference.empty()){
+            Reference = Distances;
+        }
+        for(std::size_t Index = 0; Index < Distances.size(); Index++){
+            Mismatches += std::fabs(Distances[Index] - Reference[Index]) > 1e-9 ? 1 : 0;
+        }
+        std::cout<<Benchmark.DName<<": "<<Duration.count() / 1000.0<<" ms for "<<NumQueries<<" queries";
+        std::cout<<" ("<<double(Duration.count()) / NumQueries<<" us/query), "<<Mismatches<<" mismatches\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,8 +1,11 @@
 #include "TransportationPlannerConfig.h"
 #include "DijkstraTransportationPlanner.h"
+#include "MemoryMappedFile.h"
 #include "OpenStreetMap.h"
 #include "CSVBusSystem.h"
 #include "FileDataFactory.h"
+#include "FileDataSource.h"
+#include "FileDataSink.h"
 #include "StandardDataSource.h"
 #include "StandardDataSink.h"
 #include "StandardErrorDataSink.h"
@@ -13,15 +16,22 @@
 #include <chrono>
 #include <vector>
 #include <cmath>
+#include <fstream>
+#include <stdexcept>
 
 class CArgumentParser{
     private:
         std::string DDataDirectory;
         std::string DResultsDirectory;
+        std::string DSnapshot;
+        std::string DMap;
         uint64_t DNumPoints;
         uint64_t DSeed;
+        uint64_t DThreads;
         bool DArgumentsValid;
         bool DVerbose;
+        bool DBatch;
+        bool DFilter;
         
         void PrintSyntax() const;
     public:
@@ -31,7 +41,12 @@ class CArgumentParser{
 
         std::string DataDirectory() const;
         std::string ResultsDirectory() const;
+        std::string Snapshot() const;
+        std::string Map() const;
         bool Verbose() const;
+        bool Batch() const;
+        bool Filter() const;
+        uint64_t Threads() const;
         uint64_t NumPoints() const;
         uint64_t Seed() const;
 };
@@ -58,15 +73,14 @@ class CSpeedTest{
         void NotifyString(const std::string &str);
         void WriteStringToSink(std::shared_ptr<CDataSink> sink, const std::string &str);
     public:
-        CSpeedTest(std::shared_ptr<CDataSink> out, std::shared_ptr<CDataSink> notify, std::shared_ptr<CTransportationPlanner::SConfiguration> config);
+        CSpeedTest(std::shared_ptr<CDataSink> out, std::shared_ptr<CDataSink> notify, std::shared_ptr<CTransportationPlanner::SConfiguration> config, const std::string &snapshot = "");
 
-        bool RunTest(uint64_t seed, uint64_t numpoints, bool verbose);
+        bool RunTest(uint64_t seed, uint64_t numpoints, bool verbose, bool batch = false, uint64_t threads = 0);
         bool OutputResults(std::shared_ptr<CDataFactory> results, bool verbose);
 };
 
 int main(int argc, char *argv[]){
     std::vector<std::string> Arguments;
-    const std::string OSMFilename = "city.osm";
     const std::string StopFilename = "stops.csv";
     const std::string RouteFilename = "routes.csv";
 
@@ -84,16 +98,47 @@ int main(int argc, char *argv[]){
     auto StdIn = std::make_shared<CStandardDataSource>();
     auto StdOut = std::make_shared<CStandardDataSink>();
     auto StdErr = std::make_shared<CStandardErrorDataSink>();
-    auto StopReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(StopFilename),',');
-    auto RouteReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(RouteFilename),',');
-    auto BusSystem = std::make_shared<CCSVBusSystem>(StopReader, RouteReader);
-    auto XMLReader = std::make_shared<CXMLReader>(DataFactory->CreateSource(OSMFilename));
-    auto StreetMap = std::make_shared<COpenStreetMap>(XMLReader);
+    // with an existing snapshot the planner is loaded from it and the data files are never read
+    std::shared_ptr<CStreetMap> StreetMap;
+    std::shared_ptr<CBusSystem> BusSystem;
+    if(Parser.Snapshot().empty() || !std::ifstream(Parser.Snapshot()).good()){
+        auto StopReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(StopFilename),',');
+        auto RouteReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(RouteFilename),',');
+        BusSystem = std::make_shared<CCSVBusSystem>(StopReader, RouteReader);
+        // the map is parsed in pieces on the same number of threads the queries get, it can be XML or PBF
+        if(Parser.Filter()){
+            // only the roads and the nodes on them, the bus stops have to stay even if no road uses them
+            auto Filter = COpenStreetMap::SFilter::Routing();
+            for(std::size_t Index = 0; Index < BusSystem->StopCount(); Index++){
+                Filter.Nodes.push_back(BusSystem->StopByIndex(Index)->NodeID());
+            }
+            auto FilteredMap = std::make_shared<COpenStreetMap>(DataFactory->CreateSource(Parser.Map()), Filter, Parser.Threads());
+            auto Counts = FilteredMap->FilterCounts();
+            // the counts go out with the other status messages
+            std::string Notify = "Filter nodes: " + std::to_string(Counts.NodesBefore) + " -> " + std::to_string(Counts.NodesAfter) + "\n";
+            Notify += "Filter ways: " + std::to_string(Counts.WaysBefore) + " -> " + std::to_string(Counts.WaysAfter) + "\n";
+            Notify += "Filter tags: " + std::to_string(Counts.TagsBefore) + " -> " + std::to_string(Counts.TagsAfter) + "\n";
+            Notify += "Filter strings: " + std::to_string(Counts.StringsBefore) + " -> " + std::to_string(Counts.StringsAfter) + "\n";
+            StdErr->Write(std::vector<char>(Notify.begin(),Notify.end()));
+            StreetMap = FilteredMap;
+        }
+        else{
+            StreetMap = std::make_shared<COpenStreetMap>(DataFactory->CreateSource(Parser.Map()), Parser.Threads());
+        }
+    }
     auto PlannerConfig = std::make_shared<STransportationPlannerConfig>(StreetMap, BusSystem);
 
-    CSpeedTest SpeedTester(StdOut,StdErr,PlannerConfig);
+    std::unique_ptr<CSpeedTest> SpeedTesterPointer;
+    try{
+        SpeedTesterPointer = std::make_unique<CSpeedTest>(StdOut,StdErr,PlannerConfig,Parser.Snapshot());
+    }
+    catch(std::invalid_argument &Error){
+        std::cerr<<Error.what()<<", remove "<<Parser.Snapshot()<<" to rebuild it"<<std::endl;
+        return EXIT_FAILURE;
+    }
+    CSpeedTest &SpeedTester = *SpeedTesterPointer;
 
-    if(SpeedTester.RunTest(Parser.Seed(),Parser.NumPoints(),Parser.Verbose())){
+    if(SpeedTester.RunTest(Parser.Seed(),Parser.NumPoints(),Parser.Verbose(),Parser.Batch(),Parser.Threads())){
         if(SpeedTester.OutputResults(ResultsFactory,Parser.Verbose())){
             return EXIT_SUCCESS;        
         }
@@ -105,10 +150,14 @@ int main(int argc, char *argv[]){
 CArgumentParser::CArgumentParser(const std::vector<std::string> &args){
     DDataDirectory = "./data";
     DResultsDirectory = "./results";
+    DMap = "city.osm";
     DArgumentsValid = true;
     DNumPoints = 0;
     DSeed = 0;
     DVerbose = false;
+    DBatch = false;
+    DFilter = false;
+    DThreads = 0;
     for(auto &Argument : args){
         if(Argument.find("--data") == 0){
             auto SplitArg = StringUtils::Split(Argument,"=");
@@ -134,9 +183,37 @@ CArgumentParser::CArgumentParser(const std::vector<std::string> &args){
             }
             DSeed = std::stoull(SplitArg[1]);
         }
+        else if(Argument.find("--snapshot") == 0){
+            auto SplitArg = StringUtils::Split(Argument,"=");
+            if(SplitArg.size() != 2 || SplitArg[0] != "--snapshot"){
+                DArgumentsValid = false;
+                break;
+            }
+            DSnapshot = SplitArg[1];
+        }
+        else if(Argument.find("--map") == 0){
+            auto SplitArg = StringUtils::Split(Argument,"=");
+            if(SplitArg.size() != 2 || SplitArg[0] != "--map"){
+                DArgumentsValid = false;
+                break;
+            }
+            DMap = SplitArg[1];
+        }
         else if(Argument == "--verbose"){
             DVerbose = true;
         }
+        else if(Argument == "--filter"){
+            DFilter = true;
+        }
+        else if(Argument.find("--threads") == 0){
+            auto SplitArg = StringUtils::Split(Argument,"=");
+            if(SplitArg.size() > 2 || SplitArg[0] != "--threads"){
+                DArgumentsValid = false;
+                break;
+            }
+            DBatch = true;
+            DThreads = SplitArg.size() == 2 ? std::stoull(SplitArg[1]) : 0;
+        }
         else{
             if(DNumPoints){
                 DArgumentsValid = false;
@@ -159,7 +236,7 @@ CArgumentParser::CArgumentParser(const std::vector<std::string> &args){
 }
 
 void CArgumentParser::PrintSyntax() const{
-    std::cerr<<"Syntax Error: speedtest [--data=path | --results=path | --seed=rngseed | --verbose] [numpoints]"<<std::endl;
+    std::cerr<<"Syntax Error: speedtest [--data=path | --results=path | --snapshot=file | --map=file | --filter | --seed=rngseed | --verbose | --threads[=count]] [numpoints]"<<std::endl;
 }
 
 bool CArgumentParser::ArgumentsValid() const{
@@ -174,10 +251,30 @@ std::string CArgumentParser::ResultsDirectory() const{
     return DResultsDirectory;
 }
 
+std::string CArgumentParser::Snapshot() const{
+    return DSnapshot;
+}
+
+std::string CArgumentParser::Map() const{
+    return DMap;
+}
+
 bool CArgumentParser::Verbose() const{
     return DVerbose;
 }
 
+bool CArgumentParser::Batch() const{
+    return DBatch;
+}
+
+bool CArgumentParser::Filter() const{
+    return DFilter;
+}
+
+uint64_t CArgumentParser::Threads() const{
+    return DThreads;
+}
+
 uint64_t CArgumentParser::NumPoints() const{
     return DNumPoints;
 }
@@ -186,15 +283,27 @@ uint64_t CArgumentParser::Seed() const{
     return DSeed;
 }
 
-CSpeedTest::CSpeedTest(std::shared_ptr<CDataSink> out, std::shared_ptr<CDataSink> notify, std::shared_ptr<CTransportationPlanner::SConfiguration> config){
+// a config without a street map means main found the snapshot, so the planner is loaded from it,
+// otherwise the planner is built and then saved to the snapshot if there is one
+CSpeedTest::CSpeedTest(std::shared_ptr<CDataSink> out, std::shared_ptr<CDataSink> notify, std::shared_ptr<CTransportationPlanner::SConfiguration> config, const std::string &snapshot){
     const int MillisecondsPerSecond = 1000;
     DOutput = out;
     DNotify = notify;
     NotifyString("Loading\n");
     auto LoadStart = std::chrono::steady_clock::now();
-    DPlanner = std::make_shared<CDijkstraTransportationPlanner>(config);
+    std::shared_ptr<CDijkstraTransportationPlanner> Planner;
+    if(!snapshot.empty() && !config->StreetMap()){
+        Planner = std::make_shared<CDijkstraTransportationPlanner>(config, std::make_shared<CMemoryMappedFile>(snapshot));
+    }
+    else{
+        Planner = std::make_shared<CDijkstraTransportationPlanner>(config);
+    }
     auto LoadDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-LoadStart);
+    DPlanner = Planner;
     NotifyString("Loaded\n");
+    if(!snapshot.empty() && config->StreetMap()){
+        NotifyString(Planner->Save(std::make_shared<CFileDataSink>(snapshot)) ? "Saved snapshot\n" : "Failed to save snapshot\n");
+    }
     DViolatedPrecomputeTime = config->PrecomputeTime() * MillisecondsPerSecond < LoadDuration.count();
     if(DViolatedPrecomputeTime){
         NotifyString("Violated precompute time!!!\n");
@@ -288,7 +397,7 @@ void CSpeedTest::WriteStringToSink(std::shared_ptr<CDataSink> sink, const std::s
     sink->Write(std::vector<char>(str.begin(),str.end()));
 }
 
-bool CSpeedTest::RunTest(uint64_t seed, uint64_t numpoints, bool verbose){
+bool CSpeedTest::RunTest(uint64_t seed, uint64_t numpoints, bool verbose, bool batch, uint64_t threads){
     std::vector< CStreetMap::TNodeID > TempShortestPath;
     std::vector< CTransportationPlanner::TTripStep > TempFastestPath;
     std::vector< std::pair< CStreetMap::TNodeID , CStreetMap::TNodeID > > RandomNodePairs;
@@ -310,7 +419,12 @@ bool CSpeedTest::RunTest(uint64_t seed, uint64_t numpoints, bool verbose){
     DFastestTime.resize(numpoints);
     NotifyString("Finding paths\n");
     auto ProcessingStart = std::chrono::steady_clock::now();
-    for(uint64_t Index = 0; Index < numpoints; Index++){
+    if(batch){
+        // --threads hands every pair to the planner at once and it spreads them over its worker threads
+        DPlanner->FindShortestPaths(RandomNodePairs, DShortestDistance, DShortestPaths, threads);
+        DPlanner->FindFastestPaths(RandomNodePairs, DFastestTime, DFastestPaths, threads);
+    }
+    for(uint64_t Index = 0; !batch && Index < numpoints; Index++){
         auto SourceNodeID = std::get<0>(RandomNodePairs[Index]);
         auto DestNodeID = std::get<1>(RandomNodePairs[Index]);
         std::vector< CStreetMap::TNodeID > &ShortestPath = verbose ? DShortestPaths[Index] : TempShortestPath;
@@ -295,4 +295,338 @@ TEST(CSVOSMTransporationPlanner, PathDescription){
     EXPECT_EQ(Description3, ExpectedDescription3);
 
 }
-    */
\ No newline at end of file
+    */
+#include <gtest/gtest.h>
+#include "XMLReader.h"
+#include "StringDataSource.h"
+#include "StringDataSink.h"
+#include "FileDataFactory.h"
+#include "MemoryMappedFile.h"
+#include "OpenStreetMap.h"
+#include "CSVBusSystem.h"
+#include "TransportationPlannerConfig.h"
+#include "DijkstraTransportationPlanner.h"
+#include "GeographicUtils.h"
+#include <algorithm>
+#include <cstdio>
+
+// Assume being run from Makefile so testtmp is subdirectory
+const std::string BaseDirectory = "./testtmp/";
+
+// junctions 1 and 2 have two streets between them, 1-10-11-12-2 straight across and 20-21 bending north (longer),
+// and a one way street 2->30->31->1 back along the south. 3 and 4 hang off 1 and 2, and 4 has a loop 40-41-42 that
+// only comes back to 4
+static const char *ChainOSM = "<?xml version='1.0' encoding='UTF-8'?>"
+                              "<osm version=\"0.6\">"
+                              "<node id=\"1\" lat=\"38.50\" lon=\"-121.70\"><tag k=\"highway\" v=\"traffic_signals\"/></node>"
+                              "<node id=\"2\" lat=\"38.50\" lon=\"-121.74\"/>"
+                              "<node id=\"3\" lat=\"38.50\" lon=\"-121.69\"/>"
+                              "<node id=\"4\" lat=\"38.50\" lon=\"-121.75\"/>"
+                              "<node id=\"10\" lat=\"38.50\" lon=\"-121.71\"/>"
+                              "<node id=\"11\" lat=\"38.50\" lon=\"-121.72\"/>"
+                              "<node id=\"12\" lat=\"38.50\" lon=\"-121.73\"/>"
+                              "<node id=\"20\" lat=\"38.52\" lon=\"-121.71\"/>"
+                              "<node id=\"21\" lat=\"38.52\" lon=\"-121.73\"/>"
+                              "<node id=\"30\" lat=\"38.48\" lon=\"-121.73\"/>"
+                              "<node id=\"31\" lat=\"38.48\" lon=\"-121.71\"/>"
+                              "<node id=\"40\" lat=\"38.51\" lon=\"-121.76\"/>"
+                              "<node id=\"41\" lat=\"38.51\" lon=\"-121.77\"/>"
+                              "<node id=\"42\" lat=\"38.49\" lon=\"-121.77\"/>"
+                              "<way id=\"100\"><nd ref=\"3\"/><nd ref=\"1\"/><nd ref=\"10\"/></way>"
+                              "<way id=\"101\"><nd ref=\"10\"/><nd ref=\"11\"/><nd ref=\"12\"/><nd ref=\"2\"/><nd ref=\"4\"/></way>"
+                              "<way id=\"102\"><nd ref=\"1\"/><nd ref=\"20\"/><nd ref=\"21\"/><nd ref=\"2\"/></way>"
+                              "<way id=\"103\"><nd ref=\"2\"/><nd ref=\"30\"/><nd ref=\"31\"/><nd ref=\"1\"/><tag k=\"oneway\" v=\"yes\"/></way>"
+                              "<way id=\"104\"><nd ref=\"4\"/><nd ref=\"40\"/><nd ref=\"41\"/><nd ref=\"42\"/><nd ref=\"4\"/></way>"
+                              "</osm>";
+
+static std::shared_ptr<STransportationPlannerConfig> ChainConfig(int precompute, const std::string &stops = "stop_id,node_id", const std::string &routes = "route,stop_id"){
+    auto XMLReader = std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(ChainOSM));
+    auto CSVReaderStops = std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(stops),',');
+    auto CSVReaderRoutes = std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(routes),',');
+    auto StreetMap = std::make_shared<COpenStreetMap>(XMLReader);
+    auto BusSystem = std::make_shared<CCSVBusSystem>(CSVReaderStops, CSVReaderRoutes);
+    return std::make_shared<STransportationPlannerConfig>(StreetMap,BusSystem,3.0,8.0,25.0,30.0,precompute);
+}
+
+// bus stops along 3 1 2 4, so trips that follow them get bus steps
+static std::shared_ptr<STransportationPlannerConfig> BusChainConfig(int precompute = 5){
+    return ChainConfig(precompute,"stop_id,node_id\n101,3\n102,1\n103,2\n104,4","route,stop_id\nA,101\nA,102\nA,103\nA,104\nB,104\nB,103");
+}
+
+TEST(CSVOSMTransporationPlanner, BatchQueryTest){
+    CDijkstraTransportationPlanner Planner(BusChainConfig());
+    // every pair of nodes plus unknown ids on either end, in an order that isnt sorted
+    std::vector< std::pair< CTransportationPlanner::TNodeID, CTransportationPlanner::TNodeID > > Pairs = {{99,1}, {1,99}, {0,0}};
+    for(std::size_t SrcIndex = Planner.NodeCount(); SrcIndex-- > 0;){
+        for(std::size_t DestIndex = 0; DestIndex < Planner.NodeCount(); DestIndex++){
+            Pairs.push_back({Planner.SortedNodeByIndex(SrcIndex)->ID(),Planner.SortedNodeByIndex(DestIndex)->ID()});
+        }
+    }
+    Pairs.push_back({42,99});
+
+    // one thread runs them in the calling thread, four share the planner and a counter
+    for(std::size_t ThreadCount : {1, 4}){
+        std::vector< double > Distances, Times;
+        std::vector< std::vector< CTransportationPlanner::TNodeID > > Paths;
+        std::vector< std::vector< CTransportationPlanner::TTripStep > > Trips;
+        Planner.FindShortestPaths(Pairs,Distances,Paths,ThreadCount);
+        Planner.FindFastestPaths(Pairs,Times,Trips,ThreadCount);
+        ASSERT_EQ(Distances.size(),Pairs.size());
+        ASSERT_EQ(Paths.size(),Pairs.size());
+        ASSERT_EQ(Times.size(),Pairs.size());
+        ASSERT_EQ(Trips.size(),Pairs.size());
+        std::vector< CTransportationPlanner::TNodeID > Path;
+        std::vector< CTransportationPlanner::TTripStep > Trip;
+        for(std::size_t Index = 0; Index < Pairs.size(); Index++){
+            auto [Src, Dest] = Pairs[Index];
+            EXPECT_EQ(Distances[Index],Planner.FindShortestPath(Src,Dest,Path)) << Src << " -> " << Dest;
+            EXPECT_EQ(Paths[Index],Path) << Src << " -> " << Dest;
+            EXPECT_EQ(Times[Index],Planner.FindFastestPath(Src,Dest,Trip)) << Src << " -> " << Dest;
+            EXPECT_EQ(Trips[Index],Trip) << Src << " -> " << Dest;
+        }
+        EXPECT_EQ(Distances[0],CPathRouter::NoPathExists);
+        EXPECT_TRUE(Paths[1].empty());
+        EXPECT_EQ(Times.back(),CPathRouter::NoPathExists);
+        EXPECT_TRUE(Trips.back().empty());
+    }
+
+    std::vector< double > Distances = {1.0};
+    std::vector< std::vector< CTransportationPlanner::TNodeID > > Paths = {{1}};
+    Planner.FindShortestPaths({},Distances,Paths,4);
+    EXPECT_TRUE(Distances.empty());
+    EXPECT_TRUE(Paths.empty());
+}
+
+TEST(CSVOSMTransporationPlanner, DistanceTableTest){
+    // without a hierarchy the matrix is one search per source, with one it uses the buckets
+    for(int Precompute : {0, 5}){
+        CDijkstraTransportationPlanner Planner(BusChainConfig(Precompute));
+        std::vector< CTransportationPlanner::TNodeID > Nodes = {99};
+        for(std::size_t Index = 0; Index < Planner.NodeCount(); Index++){
+            Nodes.push_back(Planner.SortedNodeByIndex(Index)->ID());
+        }
+        Nodes.push_back(0);
+
+        auto DistanceMatrix = Planner.FindShortestDistanceMatrix(Nodes,Nodes);
+        auto TimeMatrix = Planner.FindFastestTimeMatrix(Nodes,Nodes);
+        ASSERT_EQ(DistanceMatrix.size(),Nodes.size());
+        ASSERT_EQ(TimeMatrix.size(),Nodes.size());
+        std::vector< CTransportationPlanner::TNodeID > Path;
+        std::vector< CTransportationPlanner::TTripStep > Trip;
+        for(std::size_t Row = 0; Row < Nodes.size(); Row++){
+            auto Distances = Planner.FindShortestDistances(Nodes[Row],Nodes);
+            auto Times = Planner.FindFastestTimes(Nodes[Row],Nodes);
+            ASSERT_EQ(Distances.size(),Nodes.size());
+            ASSERT_EQ(Times.size(),Nodes.size());
+            ASSERT_EQ(DistanceMatrix[Row].size(),Nodes.size());
+            ASSERT_EQ(TimeMatrix[Row].size(),Nodes.size());
+            for(std::size_t Col = 0; Col < Nodes.size(); Col++){
+                double Distance = Planner.FindShortestPath(Nodes[Row],Nodes[Col],Path);
+                double Time = Planner.FindFastestPath(Nodes[Row],Nodes[Col],Trip);
+                // unknown ids at either end have no path
+                if(Row == 0 || Col == 0 || Row + 1 == Nodes.size() || Col + 1 == Nodes.size()){
+                    EXPECT_EQ(Distance,CPathRouter::NoPathExists);
+                    EXPECT_EQ(Time,CPathRouter::NoPathExists);
+                }
+                for(double Cell : {Distances[Col], DistanceMatrix[Row][Col]}){
+                    if(Distance == CPathRouter::NoPathExists){
+                        EXPECT_EQ(Cell,CPathRouter::NoPathExists) << Nodes[Row] << " -> " << Nodes[Col];
+                    }
+                    else{
+                        EXPECT_DOUBLE_EQ(Cell,Distance) << Nodes[Row] << " -> " << Nodes[Col];
+                    }
+                }
+                for(double Cell : {Times[Col], TimeMatrix[Row][Col]}){
+                    if(Time == CPathRouter::NoPathExists){
+                        EXPECT_EQ(Cell,CPathRouter::NoPathExists) << Nodes[Row] << " -> " << Nodes[Col];
+                    }
+                    else{
+                        EXPECT_DOUBLE_EQ(Cell,Time) << Nodes[Row] << " -> " << Nodes[Col];
+                    }
+                }
+            }
+        }
+        EXPECT_TRUE(Planner.FindShortestDistanceMatrix({},Nodes).empty());
+        EXPECT_TRUE(Planner.FindFastestTimes(1,{}).empty());
+    }
+}
+
+// same nodes and the same answer to every shortest and fastest path query
+static void ExpectSamePlanner(const CDijkstraTransportationPlanner &expected, const CDijkstraTransportationPlanner &actual){
+    ASSERT_EQ(actual.NodeCount(),expected.NodeCount());
+    for(std::size_t Index = 0; Index < expected.NodeCount(); Index++){
+        auto ExpectedNode = expected.SortedNodeByIndex(Index), ActualNode = actual.SortedNodeByIndex(Index);
+        ASSERT_TRUE(ActualNode);
+        EXPECT_EQ(ActualNode->ID(),ExpectedNode->ID());
+        EXPECT_EQ(ActualNode->Location(),ExpectedNode->Location());
+        ASSERT_EQ(ActualNode->AttributeCount(),ExpectedNode->AttributeCount());
+        for(std::size_t Attribute = 0; Attribute < ExpectedNode->AttributeCount(); Attribute++){
+            auto Key = ExpectedNode->GetAttributeKey(Attribute);
+            EXPECT_EQ(ActualNode->GetAttributeKey(Attribute),Key);
+            EXPECT_EQ(ActualNode->GetAttribute(Key),ExpectedNode->GetAttribute(Key));
+        }
+    }
+    EXPECT_FALSE(actual.SortedNodeByIndex(expected.NodeCount()));
+    std::vector< CTransportationPlanner::TNodeID > ExpectedPath, ActualPath;
+    std::vector< CTransportationPlanner::TTripStep > ExpectedTrip, ActualTrip;
+    for(std::size_t SrcIndex = 0; SrcIndex < expected.NodeCount(); SrcIndex++){
+        for(std::size_t DestIndex = 0; DestIndex < expected.NodeCount(); DestIndex++){
+            auto Src = expected.SortedNodeByIndex(SrcIndex)->ID(), Dest = expected.SortedNodeByIndex(DestIndex)->ID();
+            EXPECT_EQ(actual.FindShortestPath(Src,Dest,ActualPath),expected.FindShortestPath(Src,Dest,ExpectedPath));
+            EXPECT_EQ(ActualPath,ExpectedPath);
+            EXPECT_EQ(actual.FindFastestPath(Src,Dest,ActualTrip),expected.FindFastestPath(Src,Dest,ExpectedTrip));
+            EXPECT_EQ(ActualTrip,ExpectedTrip);
+        }
+    }
+}
+
+TEST(CSVOSMTransporationPlanner, SnapshotTest){
+    CDijkstraTransportationPlanner Planner(BusChainConfig());
+    // the bus steps come from the route info the snapshot has to carry
+    std::vector< CTransportationPlanner::TTripStep > Trip;
+    EXPECT_NE(Planner.FindFastestPath(3,2,Trip),CPathRouter::NoPathExists);
+    EXPECT_TRUE(std::any_of(Trip.begin(),Trip.end(),[](auto &step){ return step.first == CTransportationPlanner::ETransportationMode::Bus; }));
+
+    auto Sink = std::make_shared<CStringDataSink>();
+    ASSERT_TRUE(Planner.Save(Sink));
+    const std::string Snapshot = Sink->String();
+    // the street map and bus system arent needed to load, only the same speeds and stop time
+    auto Config = std::make_shared<STransportationPlannerConfig>(nullptr,nullptr,3.0,8.0,25.0,30.0,5);
+    CDijkstraTransportationPlanner Loaded(Config,std::make_shared<CStringDataSource>(Snapshot));
+    ExpectSamePlanner(Planner,Loaded);
+
+    // a flipped payload byte fails the checksum, the version is the 4 bytes after the 8 byte magic
+    std::string Damaged = Snapshot;
+    Damaged[Damaged.size() / 2] ^= 0x40;
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,std::make_shared<CStringDataSource>(Damaged)),std::invalid_argument);
+    std::string OtherVersion = Snapshot;
+    OtherVersion[8] ^= 0x01;
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,std::make_shared<CStringDataSource>(OtherVersion)),std::invalid_argument);
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,std::make_shared<CStringDataSource>(Snapshot.substr(0,Snapshot.size() - 8))),std::invalid_argument);
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,std::make_shared<CStringDataSource>("")),std::invalid_argument);
+    // the weights depend on the speeds, so a different walk speed cant use it
+    auto OtherWalkSpeed = std::make_shared<STransportationPlannerConfig>(nullptr,nullptr,4.0,8.0,25.0,30.0,5);
+    EXPECT_THROW(CDijkstraTransportationPlanner(OtherWalkSpeed,std::make_shared<CStringDataSource>(Snapshot)),std::invalid_argument);
+}
+
+TEST(CSVOSMTransporationPlanner, MappedSnapshotTest){
+    CDijkstraTransportationPlanner Planner(BusChainConfig());
+    auto Sink = std::make_shared<CStringDataSink>();
+    ASSERT_TRUE(Planner.Save(Sink));
+    const std::string &Snapshot = Sink->String();
+    // the snapshots are written where the other tests put their files
+    CFileDataFactory DataFactory(BaseDirectory);
+    ASSERT_TRUE(DataFactory.CreateSink("planner.snapshot")->Write(std::vector<char>(Snapshot.begin(),Snapshot.end())));
+    ASSERT_TRUE(DataFactory.CreateSink("truncated.snapshot")->Write(std::vector<char>(Snapshot.begin(),Snapshot.begin() + Snapshot.size() / 2)));
+
+    // the routers search the graph arrays in the mapping, which they keep alive after the file is gone
+    auto Config = std::make_shared<STransportationPlannerConfig>(nullptr,nullptr,3.0,8.0,25.0,30.0,5);
+    auto Mapping = std::make_shared<CMemoryMappedFile>(BaseDirectory + "planner.snapshot");
+    ASSERT_TRUE(Mapping->Valid());
+    CDijkstraTransportationPlanner Mapped(Config,std::shared_ptr<const CMemoryMappedFile>(Mapping));
+    Mapping.reset();
+    std::remove((BaseDirectory + "planner.snapshot").c_str());
+    CDijkstraTransportationPlanner Copied(Config,std::make_shared<CStringDataSource>(Snapshot));
+    ExpectSamePlanner(Copied,Mapped);
+    ExpectSamePlanner(Planner,Mapped);
+
+    // a file cut short, or one that couldnt be mapped
+    auto TruncatedMapping = std::make_shared<const CMemoryMappedFile>(BaseDirectory + "truncated.snapshot");
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,TruncatedMapping),std::invalid_argument);
+    std::remove((BaseDirectory + "truncated.snapshot").c_str());
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,std::make_shared<const CMemoryMappedFile>(BaseDirectory + "missing.snapshot")),std::invalid_argument);
+    EXPECT_THROW(CDijkstraTransportationPlanner(Config,std::shared_ptr<const CMemoryMappedFile>()),std::invalid_argument);
+}
+
+// the distance of a path added up a step at a time
+static double PathDistance(const CDijkstraTransportationPlanner &planner, const std::vector< CTransportationPlanner::TNodeID > &path){
+    auto Location = [&planner](CTransportationPlanner::TNodeID id){
+        for(std::size_t Index = 0; Index < planner.NodeCount(); Index++){
+            if(planner.SortedNodeByIndex(Index)->ID() == id){
+                return planner.SortedNodeByIndex(Index)->Location();
+            }
+        }
+        return CStreetMap::TLocation();
+    };
+    double Distance = 0;
+    for(std::size_t Index = 1; Index < path.size(); Index++){
+        Distance += SGeographicUtils::HaversineDistanceInMiles(Location(path[Index - 1]),Location(path[Index]));
+    }
+    return Distance;
+}
+
+// in ChainOSM only 1, 2, 3 and 4 are junctions, every other node is in the middle of a chain and isnt a router vertex
+TEST(CSVOSMTransporationPlanner, ContractedChainTest){
+    // precompute 0 searches with bidirectional dijkstra, 5 with the contraction hierarchy
+    for(int Precompute : {0, 5}){
+        CDijkstraTransportationPlanner Planner(ChainConfig(Precompute));
+        EXPECT_EQ(Planner.NodeCount(),14);
+        std::vector< CTransportationPlanner::TNodeID > Path;
+        auto ExpectPath = [&](CTransportationPlanner::TNodeID src, CTransportationPlanner::TNodeID dest, const std::vector< CTransportationPlanner::TNodeID > &expected){
+            double Distance = Planner.FindShortestPath(src,dest,Path);
+            EXPECT_EQ(Path,expected) << src << " -> " << dest;
+            EXPECT_DOUBLE_EQ(Distance,PathDistance(Planner,expected)) << src << " -> " << dest;
+        };
+        // middle of one chain to the middle of another, out through 2 and into the loop from the 40 end
+        ExpectPath(11,41,{11,12,2,4,40,41});
+        // junction to junction picks the shorter of the two parallel chains, both ways
+        ExpectPath(1,2,{1,10,11,12,2});
+        ExpectPath(2,1,{2,12,11,10,1});
+        // on the longer parallel chain it is still shorter to stay on it than to go back to the other one
+        ExpectPath(21,1,{21,20,1});
+        ExpectPath(3,20,{3,1,20});
+        // both on the same chain, both directions
+        ExpectPath(10,12,{10,11,12});
+        ExpectPath(12,10,{12,11,10});
+        ExpectPath(11,11,{11});
+        // the one way chain, with it and against it (around through 1 and 2)
+        ExpectPath(30,31,{30,31});
+        ExpectPath(31,30,{31,1,10,11,12,2,30});
+        ExpectPath(12,31,{12,2,30,31});
+        // the loop only has the one junction, along the loop or out through 4 whichever is shorter
+        ExpectPath(40,42,{40,41,42});
+        ExpectPath(42,40,{42,41,40});
+        ExpectPath(3,42,{3,1,10,11,12,2,4,42});
+        ExpectPath(42,3,{42,4,2,12,11,10,1,3});
+
+        EXPECT_EQ(Planner.FindShortestPath(11,99,Path),CPathRouter::NoPathExists);
+        EXPECT_TRUE(Path.empty());
+        EXPECT_EQ(Planner.FindShortestPath(99,11,Path),CPathRouter::NoPathExists);
+        EXPECT_TRUE(Path.empty());
+
+        // the tables on chain nodes agree with the single queries
+        std::vector< CTransportationPlanner::TNodeID > Sources = {11, 31, 41, 3, 99}, Dests = {10, 30, 42, 11, 4, 99};
+        auto Matrix = Planner.FindShortestDistanceMatrix(Sources,Dests);
+        ASSERT_EQ(Matrix.size(),Sources.size());
+        for(std::size_t Row = 0; Row < Sources.size(); Row++){
+            auto Distances = Planner.FindShortestDistances(Sources[Row],Dests);
+            ASSERT_EQ(Matrix[Row].size(),Dests.size());
+            ASSERT_EQ(Distances.size(),Dests.size());
+            for(std::size_t Col = 0; Col < Dests.size(); Col++){
+                double Expected = Planner.FindShortestPath(Sources[Row],Dests[Col],Path);
+                if(Expected == CPathRouter::NoPathExists){
+                    EXPECT_EQ(Matrix[Row][Col],CPathRouter::NoPathExists);
+                    EXPECT_EQ(Distances[Col],CPathRouter::NoPathExists);
+                }
+                else{
+                    EXPECT_DOUBLE_EQ(Matrix[Row][Col],Expected) << Sources[Row] << " -> " << Dests[Col];
+                    EXPECT_DOUBLE_EQ(Distances[Col],Expected) << Sources[Row] << " -> " << Dests[Col];
+                }
+            }
+        }
+
+        // a version 3 snapshot keeps the chains, so a loaded planner unpacks the same paths
+        auto Sink = std::make_shared<CStringDataSink>();
+        ASSERT_TRUE(Planner.Save(Sink));
+        auto Config = std::make_shared<STransportationPlannerConfig>(nullptr,nullptr,3.0,8.0,25.0,30.0,Precompute);
+        CDijkstraTransportationPlanner Loaded(Config,std::make_shared<CStringDataSource>(Sink->String()));
+        std::vector< CTransportationPlanner::TNodeID > LoadedPath;
+        for(std::size_t SrcIndex = 0; SrcIndex < Planner.NodeCount(); SrcIndex++){
+            for(std::size_t DestIndex = 0; DestIndex < Planner.NodeCount(); DestIndex++){
+                auto Src = Planner.SortedNodeByIndex(SrcIndex)->ID(), Dest = Planner.SortedNodeByIndex(DestIndex)->ID();
+                EXPECT_EQ(Loaded.FindShortestPath(Src,Dest,LoadedPath),Planner.FindShortestPath(Src,Dest,Path));
+                EXPECT_EQ(LoadedPath,Path);
+            }
+        }
+    }
+}
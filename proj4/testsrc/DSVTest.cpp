@@ -21,4 +21,64 @@ TEST(DSVTest, PokemonReadWrite) {
     }
 
     EXPECT_EQ(sink->String(), "Pokemon,Type,Level\nPikachu,Electric,25\nCharizard,Fire,36\n");
-}
\ No newline at end of file
+}
+// a source that cant lend its bytes and hands them out one at a time, so every quote and separator lands on a
+// chunk boundary
+class CTrickleDataSource : public CDataSource{
+    private:
+        CStringDataSource DSource;
+    public:
+        CTrickleDataSource(const std::string &str) : DSource(str){}
+        bool End() const noexcept override{ return DSource.End(); }
+        bool Get(char &ch) noexcept override{ return DSource.Get(ch); }
+        bool Peek(char &ch) noexcept override{ return DSource.Peek(ch); }
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override{ return DSource.Read(buf, count ? 1 : 0); }
+};
+
+TEST(DSVTest, QuotedFieldsAcrossChunks) {
+    const std::string data = "name,\"say \"\"hi\"\"\",\"a,b\"\n\"multi\nline\",x\nlast,\"end\"";
+    std::vector<std::vector<std::string>> expected = {{"name", "say \"hi\"", "a,b"}, {"multi\nline", "x"}, {"last", "end"}};
+    for (std::shared_ptr<CDataSource> src : {std::shared_ptr<CDataSource>(std::make_shared<CStringDataSource>(data)), std::shared_ptr<CDataSource>(std::make_shared<CTrickleDataSource>(data))}) {
+        CDSVReader reader(src, ',');
+        std::vector<std::string> row;
+        for (auto &expectedRow : expected) {
+            ASSERT_TRUE(reader.ReadRow(row));
+            EXPECT_EQ(row, expectedRow);
+        }
+        EXPECT_TRUE(reader.End());
+        EXPECT_FALSE(reader.ReadRow(row));
+    }
+}
+
+TEST(DSVTest, LongFields) {
+    // fields of every length around the 16 and 32 byte blocks the scan compares at once, with the special
+    // characters landing at every offset in a block
+    std::string data;
+    std::vector<std::vector<std::string>> expected;
+    for (size_t length = 0; length < 70; length++) {
+        std::string plain(length, 'p'), quoted = std::string(length, 'q') + ",\n";
+        data += plain + "," + "\"" + std::string(length, 'q') + ",\n\"" + "," + plain + "\n";
+        expected.push_back({plain, quoted, plain});
+    }
+    CDSVReader reader(std::make_shared<CStringDataSource>(data), ',');
+    std::vector<std::string> row;
+    for (auto &expectedRow : expected) {
+        ASSERT_TRUE(reader.ReadRow(row));
+        EXPECT_EQ(row, expectedRow);
+    }
+    EXPECT_FALSE(reader.ReadRow(row));
+}
+
+TEST(DSVTest, RowViews) {
+    const std::string data = "plain,\"quoted\",\"say \"\"hi\"\"\",,\"a\nb\"\nlast";
+    for (std::shared_ptr<CDataSource> src : {std::shared_ptr<CDataSource>(std::make_shared<CStringDataSource>(data)), std::shared_ptr<CDataSource>(std::make_shared<CTrickleDataSource>(data))}) {
+        CDSVReader reader(src, ',');
+        std::vector<std::string_view> row;
+        ASSERT_TRUE(reader.ReadRowView(row));
+        EXPECT_EQ(row, std::vector<std::string_view>({"plain", "quoted", "say \"hi\"", "", "a\nb"}));
+        ASSERT_TRUE(reader.ReadRowView(row));
+        EXPECT_EQ(row, std::vector<std::string_view>({"last"}));
+        EXPECT_FALSE(reader.ReadRowView(row));
+        EXPECT_TRUE(row.empty());
+    }
+}
@@ -1,5 +1,14 @@
 #include "DijkstraPathRouter.h"
+#include "MemoryMappedFile.h"
+#include "FileDataFactory.h"
+#include "StringDataSource.h"
+#include "StringDataSink.h"
 #include <gtest/gtest.h>
+#include <thread>
+#include <cstdio>
+
+// Assume being run from Makefile so testtmp is subdirectory
+const std::string BaseDirectory = "./testtmp/";
 
 class DijkstraPathRouterTest : public ::testing::Test {
 protected:
@@ -10,6 +19,21 @@ protected:
     void TearDown() override { 
         router.reset(); 
     }
+
+    // 0-1-2 both ways, 2->3, 0->3 and 3-4 both ways, nothing reaches 5
+    static std::unique_ptr<CDijkstraPathRouter> BuildTestGraph(CDijkstraPathRouter::ESearchMode mode) {
+        auto graph = std::make_unique<CDijkstraPathRouter>(mode);
+        for(int i = 0; i < 6; i++){
+            graph->AddVertex(i);
+        }
+        graph->AddEdge(0, 1, 1, true);
+        graph->AddEdge(1, 2, 2, true);
+        graph->AddEdge(2, 3, 1);
+        graph->AddEdge(0, 3, 5);
+        graph->AddEdge(3, 4, 1, true);
+        EXPECT_TRUE(graph->Precompute(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+        return graph;
+    }
 };
 
 
@@ -33,4 +57,316 @@ TEST_F(DijkstraPathRouterTest, ShortestPath) {
     std::vector<CPathRouter::TVertexID> path;
     EXPECT_EQ(router->FindShortestPath(v1, v3, path), 7);
     EXPECT_EQ(router->FindShortestPath(v2, v4, path), CDijkstraPathRouter::NoPathExists);
-}
\ No newline at end of file
+}
+
+TEST_F(DijkstraPathRouterTest, PrecomputeTest) {
+    auto v1 = router->AddVertex(std::string("meow"));
+    auto v2 = router->AddVertex(std::string("lala"));
+    auto v3 = router->AddVertex(std::string("cat"));
+
+    router->AddEdge(v1, v2, 5);
+    router->AddEdge(v1, v2, 2);
+    EXPECT_TRUE(router->Precompute(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_EQ(router->FindShortestPath(v1, v2, path), 2);
+    EXPECT_EQ(router->FindShortestPath(v1, v3, path), CDijkstraPathRouter::NoPathExists);
+
+    router->AddEdge(v2, v3, 1);
+    EXPECT_EQ(router->FindShortestPath(v1, v3, path), 3);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({v1, v2, v3}));
+}
+
+
+TEST_F(DijkstraPathRouterTest, ContractionHierarchiesTest) {
+    CDijkstraPathRouter hierarchy(CDijkstraPathRouter::ESearchMode::ContractionHierarchies);
+    std::vector<CPathRouter::TVertexID> ids;
+    for(int i = 0; i < 6; i++){
+        ids.push_back(hierarchy.AddVertex(i));
+    }
+    // a ring 0->1->2->3->4->5->0 with a slower chord 0->3
+    for(int i = 0; i < 6; i++){
+        hierarchy.AddEdge(ids[i], ids[(i + 1) % 6], 1);
+    }
+    hierarchy.AddEdge(ids[0], ids[3], 4);
+    EXPECT_EQ(hierarchy.SearchMode(), CDijkstraPathRouter::ESearchMode::ContractionHierarchies);
+    EXPECT_TRUE(hierarchy.Precompute(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_EQ(hierarchy.FindShortestPath(ids[0], ids[4], path), 4);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({ids[0], ids[1], ids[2], ids[3], ids[4]}));
+    EXPECT_EQ(hierarchy.FindShortestPath(ids[4], ids[1], path), 3);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({ids[4], ids[5], ids[0], ids[1]}));
+}
+
+
+TEST_F(DijkstraPathRouterTest, BidirectionalTest) {
+    CDijkstraPathRouter bidirectional(CDijkstraPathRouter::ESearchMode::Bidirectional);
+    auto v1 = bidirectional.AddVertex(std::string("meow"));
+    auto v2 = bidirectional.AddVertex(std::string("lala"));
+    auto v3 = bidirectional.AddVertex(std::string("cat"));
+    auto v4 = bidirectional.AddVertex(std::string("teehee"));
+
+    bidirectional.AddEdge(v1, v2, 5);
+    bidirectional.AddEdge(v2, v3, 6);
+    bidirectional.AddEdge(v1, v3, 12);
+    bidirectional.AddEdge(v3, v4, 1, true);
+
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_EQ(bidirectional.FindShortestPath(v1, v4, path), 12);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({v1, v2, v3, v4}));
+    EXPECT_EQ(bidirectional.FindShortestPath(v1, v1, path), 0);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({v1}));
+    EXPECT_EQ(bidirectional.FindShortestPath(v4, v1, path), CDijkstraPathRouter::NoPathExists);
+}
+
+
+TEST_F(DijkstraPathRouterTest, AStarTest) {
+    CDijkstraPathRouter astar(CDijkstraPathRouter::ESearchMode::AStar);
+    std::vector<CDijkstraPathRouter::TLocation> locations = {{0, 0}, {1, 0}, {2, 0}, {1, 1}};
+    for(std::size_t i = 0; i < locations.size(); i++){
+        astar.AddVertex(i);
+    }
+    astar.AddEdge(0, 1, 1, true);
+    astar.AddEdge(1, 2, 1, true);
+    astar.AddEdge(0, 3, 1.5, true);
+    astar.AddEdge(3, 2, 1.5, true);
+    EXPECT_FALSE(astar.SetHeuristic({{0, 0}}, nullptr));
+    EXPECT_TRUE(astar.SetHeuristic(locations, [](const CDijkstraPathRouter::TLocation &src, const CDijkstraPathRouter::TLocation &dest){
+        return std::abs(src.first - dest.first);
+    }));
+
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_EQ(astar.FindShortestPath(0, 2, path), 2);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({0, 1, 2}));
+    EXPECT_EQ(astar.FindShortestPath(3, 1, path), 2.5);
+}
+
+
+TEST_F(DijkstraPathRouterTest, LandmarksTest) {
+    CDijkstraPathRouter landmarks(CDijkstraPathRouter::ESearchMode::Landmarks);
+    for(int i = 0; i < 5; i++){
+        landmarks.AddVertex(i);
+    }
+    landmarks.AddEdge(0, 1, 2, true);
+    landmarks.AddEdge(1, 2, 2, true);
+    landmarks.AddEdge(2, 3, 2, true);
+    landmarks.AddEdge(0, 3, 7);
+    landmarks.SetLandmarkCount(2);
+    EXPECT_TRUE(landmarks.Precompute(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+    EXPECT_EQ(landmarks.LandmarkCount(), 2);
+    EXPECT_EQ(landmarks.BytesPerLandmark(), 2 * 5 * sizeof(double));
+
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_EQ(landmarks.FindShortestPath(0, 3, path), 6);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({0, 1, 2, 3}));
+    EXPECT_EQ(landmarks.FindShortestPath(3, 0, path), 6);
+    EXPECT_EQ(landmarks.FindShortestPath(0, 4, path), CDijkstraPathRouter::NoPathExists);
+}
+
+
+TEST_F(DijkstraPathRouterTest, QueuePolicyTest) {
+    for(auto policy : {CDijkstraPathRouter::EQueuePolicy::BinaryHeap, CDijkstraPathRouter::EQueuePolicy::QuaternaryHeap, CDijkstraPathRouter::EQueuePolicy::RadixHeap}){
+        CDijkstraPathRouter queued;
+        queued.SetQueuePolicy(policy);
+        EXPECT_EQ(queued.QueuePolicy(), policy);
+        for(int i = 0; i < 5; i++){
+            queued.AddVertex(i);
+        }
+        // the detour through 3 is shorter, so 2 must not be settled off the direct 0.9 edge
+        queued.AddEdge(0, 2, 0.9);
+        queued.AddEdge(0, 3, 0.25);
+        queued.AddEdge(3, 2, 0.125);
+        queued.AddEdge(2, 1, 2.5);
+
+        std::vector<CPathRouter::TVertexID> path;
+        EXPECT_EQ(queued.FindShortestPath(0, 2, path), 0.375);
+        EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({0, 3, 2}));
+        EXPECT_EQ(queued.FindShortestPath(0, 1, path), 2.875);
+        EXPECT_EQ(queued.FindShortestPath(0, 4, path), CDijkstraPathRouter::NoPathExists);
+    }
+}
+
+TEST_F(DijkstraPathRouterTest, QueryContextTest) {
+    CDijkstraPathRouter::CQueryContext context;
+    CDijkstraPathRouter small;
+    for(int i = 0; i < 3; i++){
+        small.AddVertex(i);
+    }
+    small.AddEdge(0, 1, 1);
+    small.AddEdge(1, 2, 1);
+    small.AddEdge(0, 2, 5);
+    for(int i = 0; i < 6; i++){
+        router->AddVertex(i);
+    }
+    for(int i = 0; i < 5; i++){
+        router->AddEdge(i, i + 1, 3, true);
+    }
+
+    // one context shared by two routers of different sizes, labels from an earlier query must not leak into the next
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_EQ(small.FindShortestPath(0, 2, path, context), 2);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({0, 1, 2}));
+    EXPECT_EQ(router->FindShortestPath(5, 0, path, context), 15);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({5, 4, 3, 2, 1, 0}));
+    EXPECT_EQ(small.FindShortestPath(2, 0, path, context), CDijkstraPathRouter::NoPathExists);
+    EXPECT_TRUE(path.empty());
+    EXPECT_EQ(small.FindShortestPath(1, 2, path, context), 1);
+    EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({1, 2}));
+}
+
+TEST_F(DijkstraPathRouterTest, ConcurrentQueryTest) {
+    // 6x6 grid, one way to the right and down with both ways every third row
+    const int side = 6;
+    for(int i = 0; i < side * side; i++){
+        router->AddVertex(i);
+    }
+    for(int row = 0; row < side; row++){
+        for(int col = 0; col < side; col++){
+            int v = row * side + col;
+            if(col + 1 < side){
+                router->AddEdge(v, v + 1, 1 + (v % 3), row % 3 == 0);
+            }
+            if(row + 1 < side){
+                router->AddEdge(v, v + side, 1 + (v % 2));
+            }
+        }
+    }
+    EXPECT_TRUE(router->Precompute(std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+
+    std::vector<double> expected;
+    std::vector<CPathRouter::TVertexID> path;
+    for(int src = 0; src < side * side; src++){
+        for(int dest = 0; dest < side * side; dest++){
+            expected.push_back(router->FindShortestPath(src, dest, path));
+        }
+    }
+
+    // every thread runs all the queries against the same router with its own context
+    std::vector<int> mismatches(4, 0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++){
+        threads.emplace_back([&, t](){
+            CDijkstraPathRouter::CQueryContext context;
+            const CDijkstraPathRouter &shared = *router;
+            std::vector<CPathRouter::TVertexID> threadpath;
+            for(int src = 0; src < side * side; src++){
+                for(int dest = 0; dest < side * side; dest++){
+                    if(shared.FindShortestPath(src, dest, threadpath, context) != expected[src * side * side + dest]){
+                        mismatches[t]++;
+                    }
+                }
+            }
+        });
+    }
+    for(auto &thread : threads){
+        thread.join();
+    }
+    EXPECT_EQ(mismatches, std::vector<int>(4, 0));
+}
+
+TEST_F(DijkstraPathRouterTest, DistanceMatrixTest) {
+    for(auto mode : {CDijkstraPathRouter::ESearchMode::Dijkstra, CDijkstraPathRouter::ESearchMode::ContractionHierarchies}){
+        auto tables = BuildTestGraph(mode);
+
+        CDijkstraPathRouter::CQueryContext context;
+        std::vector<double> distances;
+        // 5 is never reached and 9 is not a vertex
+        EXPECT_TRUE(tables->FindDistances(0, {4, 2, 0, 5, 9}, distances, context));
+        EXPECT_EQ(distances, std::vector<double>({5, 3, 0, CPathRouter::NoPathExists, CPathRouter::NoPathExists}));
+
+        std::vector<std::vector<double>> matrix;
+        EXPECT_TRUE(tables->FindDistanceMatrix({0, 3, 5}, {1, 3, 4}, matrix, context));
+        std::vector<std::vector<double>> expected = {{1, 4, 5}, {CPathRouter::NoPathExists, 0, 1}, {CPathRouter::NoPathExists, CPathRouter::NoPathExists, CPathRouter::NoPathExists}};
+        EXPECT_EQ(matrix, expected);
+    }
+}
+
+TEST_F(DijkstraPathRouterTest, SeededPathTest) {
+    for(auto mode : {CDijkstraPathRouter::ESearchMode::Dijkstra, CDijkstraPathRouter::ESearchMode::Bidirectional, CDijkstraPathRouter::ESearchMode::ContractionHierarchies}){
+        auto seeded = BuildTestGraph(mode);
+
+        CDijkstraPathRouter::CQueryContext context;
+        std::vector<CPathRouter::TVertexID> path;
+        // 2 + 2->3->4 + 1 beats 0 + 0->3 + 4, and 9 is not a vertex
+        EXPECT_EQ(seeded->FindShortestPath({{0, 3}, {2, 0.5}, {9, 0}}, {{4, 1}, {3, 4}}, path, context), 3.5);
+        EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({2, 3, 4}));
+        // a vertex in both is a path on its own
+        EXPECT_EQ(seeded->FindShortestPath({{1, 2}}, {{1, 0.5}, {0, 0}}, path, context), 2.5);
+        EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({1}));
+        EXPECT_EQ(seeded->FindShortestPath({{4, 0}}, {{0, 0}, {5, 0}}, path, context), CPathRouter::NoPathExists);
+        EXPECT_TRUE(path.empty());
+    }
+}
+
+TEST_F(DijkstraPathRouterTest, SnapshotTest) {
+    for(auto mode : {CDijkstraPathRouter::ESearchMode::Bidirectional, CDijkstraPathRouter::ESearchMode::Landmarks, CDijkstraPathRouter::ESearchMode::ContractionHierarchies}){
+        auto original = BuildTestGraph(mode);
+        auto sink = std::make_shared<CStringDataSink>();
+        ASSERT_TRUE(original->Save(sink));
+
+        // the loaded router takes the saved mode and answers the same without any precompute
+        CDijkstraPathRouter loaded;
+        ASSERT_TRUE(loaded.Load(std::make_shared<CStringDataSource>(sink->String())));
+        EXPECT_EQ(loaded.SearchMode(), mode);
+        EXPECT_EQ(loaded.VertexCount(), 6);
+        std::vector<CPathRouter::TVertexID> path, expected;
+        for(CPathRouter::TVertexID src = 0; src < 6; src++){
+            for(CPathRouter::TVertexID dest = 0; dest < 6; dest++){
+                EXPECT_EQ(loaded.FindShortestPath(src, dest, path), original->FindShortestPath(src, dest, expected));
+                EXPECT_EQ(path, expected);
+            }
+        }
+        // the graph can still be changed after loading
+        EXPECT_TRUE(loaded.AddEdge(4, 5, 2));
+        EXPECT_EQ(loaded.FindShortestPath(0, 5, path), 7);
+        EXPECT_EQ(path, std::vector<CPathRouter::TVertexID>({0, 1, 2, 3, 4, 5}));
+    }
+
+    // a damaged or cut off snapshot is rejected and the router keeps its graph
+    CDijkstraPathRouter original;
+    original.AddVertex(0);
+    original.AddVertex(1);
+    original.AddEdge(0, 1, 3);
+    auto sink = std::make_shared<CStringDataSink>();
+    ASSERT_TRUE(original.Save(sink));
+    std::string damaged = sink->String();
+    damaged[damaged.size() - 1] ^= 1;
+    std::vector<CPathRouter::TVertexID> path;
+    EXPECT_FALSE(router->Load(std::make_shared<CStringDataSource>(damaged)));
+    EXPECT_FALSE(router->Load(std::make_shared<CStringDataSource>(sink->String().substr(0, sink->String().size() - 1))));
+    EXPECT_FALSE(router->Load(std::make_shared<CStringDataSource>("")));
+    EXPECT_EQ(router->VertexCount(), 0);
+    EXPECT_TRUE(router->Load(std::make_shared<CStringDataSource>(sink->String())));
+    EXPECT_EQ(router->FindShortestPath(0, 1, path), 3);
+}
+
+TEST_F(DijkstraPathRouterTest, MappedSnapshotTest) {
+    auto original = BuildTestGraph(CDijkstraPathRouter::ESearchMode::ContractionHierarchies);
+    auto sink = std::make_shared<CStringDataSink>();
+    ASSERT_TRUE(original->Save(sink));
+    CFileDataFactory factory(BaseDirectory);
+    ASSERT_TRUE(factory.CreateSink("router.snapshot")->Write(std::vector<char>(sink->String().begin(), sink->String().end())));
+
+    // the router searches the arrays in the mapped file, and keeps the mapping alive on its own
+    auto mapping = std::make_shared<CMemoryMappedFile>(BaseDirectory + "router.snapshot");
+    ASSERT_TRUE(mapping->Valid());
+    auto loaded = std::make_shared<CDijkstraPathRouter>(mapping);
+    mapping.reset();
+    std::remove((BaseDirectory + "router.snapshot").c_str());
+    std::vector<CPathRouter::TVertexID> path, expected;
+    for(CPathRouter::TVertexID src = 0; src < 6; src++){
+        for(CPathRouter::TVertexID dest = 0; dest < 6; dest++){
+            EXPECT_EQ(loaded->FindShortestPath(src, dest, path), original->FindShortestPath(src, dest, expected));
+            EXPECT_EQ(path, expected);
+        }
+    }
+    // changing the graph copies it out of the mapping first
+    EXPECT_TRUE(loaded->AddEdge(4, 5, 2));
+    EXPECT_EQ(loaded->FindShortestPath(0, 5, path), 7);
+
+    // past the end of the file or not a snapshot at all
+    auto file = std::make_shared<CMemoryMappedFile>("/proc/self/cmdline");
+    EXPECT_THROW(CDijkstraPathRouter(file, 0, 1), std::invalid_argument);
+    EXPECT_THROW(CDijkstraPathRouter(nullptr), std::invalid_argument);
+}
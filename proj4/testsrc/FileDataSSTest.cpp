@@ -2,6 +2,7 @@
 #include "FileDataFactory.h"
 #include "FileDataSink.h"
 #include "FileDataSource.h"
+#include "MMapDataSource.h"
 #include <cstdio>
 
 // Assume being run from Makefile so testtmp is subdirectory
@@ -55,3 +56,237 @@ TEST(FileDataSourceSink, WriteTest){
     EXPECT_EQ(InBuffer,OutBuffer);
     EXPECT_TRUE(Source->End());
 }
+
+class FileDataSource : public ::testing::Test{
+    protected:
+        std::vector< std::string > Filenames;
+
+        // writes contents to a new file in testtmp and gives back its path
+        std::string TestFile(const std::string &contents){
+            std::string Filename = "source" + std::to_string(Filenames.size()) + ".bin";
+            CFileDataFactory DataFactory(BaseDirectory);
+            EXPECT_TRUE(DataFactory.CreateSink(Filename)->Write(std::vector<char>(contents.begin(), contents.end())));
+            Filenames.push_back(BaseDirectory + Filename);
+            return Filenames.back();
+        }
+
+        // every byte value turns up, and the pattern doesnt repeat on a block boundary
+        static std::string Contents(std::size_t size){
+            std::string Result(size, '\0');
+            for(std::size_t Index = 0; Index < size; Index++){
+                Result[Index] = char((Index * 7 + Index / 251) & 0xFF);
+            }
+            return Result;
+        }
+
+        void TearDown() override{
+            for(auto &Filename : Filenames){
+                std::remove(Filename.c_str());
+            }
+        }
+};
+
+// around the 64 KiB block, and more than two blocks
+static const std::size_t FileSizes[] = {0, 1, 65535, 65536, 65537, 131072, 200003};
+
+TEST_F(FileDataSource, GetPeekTest){
+    for(auto Size : FileSizes){
+        std::string Expected = Contents(Size);
+        CFileDataSource Source(TestFile(Expected));
+        std::string Actual;
+        char TempCh, PeekCh;
+        while(!Source.End()){
+            ASSERT_TRUE(Source.Peek(PeekCh));
+            ASSERT_TRUE(Source.Get(TempCh));
+            ASSERT_EQ(PeekCh, TempCh);
+            Actual.push_back(TempCh);
+        }
+        EXPECT_EQ(Actual.size(), Size);
+        EXPECT_TRUE(Actual == Expected) << Size;
+        TempCh = 'x';
+        EXPECT_FALSE(Source.Peek(TempCh));
+        EXPECT_FALSE(Source.Get(TempCh));
+        EXPECT_EQ(TempCh, 'x');
+    }
+}
+
+TEST_F(FileDataSource, ReadTest){
+    // small reads, reads that cross a block, and reads big enough to go straight from the file
+    const std::size_t ReadSizes[] = {1, 100, 65536, 7, 131072, 65535, 3, 300000, 65537};
+    for(auto Size : FileSizes){
+        std::string Expected = Contents(Size);
+        CFileDataSource Source(TestFile(Expected));
+        std::vector<char> Buffer;
+        std::string Actual;
+        std::size_t Step = 0;
+        while(!Source.End()){
+            std::size_t Count = ReadSizes[Step++ % (sizeof(ReadSizes) / sizeof(ReadSizes[0]))];
+            ASSERT_TRUE(Source.Read(Buffer, Count));
+            ASSERT_EQ(Buffer.size(), std::min(Count, Size - Actual.size()));
+            Actual.append(Buffer.begin(), Buffer.end());
+            // a Get in between has to carry on from where the read stopped
+            char TempCh;
+            if(!Source.End() && Step % 2){
+                ASSERT_TRUE(Source.Get(TempCh));
+                Actual.push_back(TempCh);
+            }
+        }
+        EXPECT_EQ(Actual.size(), Size);
+        EXPECT_TRUE(Actual == Expected) << Size;
+        EXPECT_FALSE(Source.Read(Buffer, 1));
+        EXPECT_TRUE(Buffer.empty());
+    }
+}
+
+TEST_F(FileDataSource, WholeFileReadTest){
+    for(auto Size : FileSizes){
+        std::string Expected = Contents(Size);
+        CFileDataSource Source(TestFile(Expected));
+        std::vector<char> Buffer;
+        EXPECT_EQ(Source.Read(Buffer, Size + 10), Size != 0);
+        EXPECT_TRUE(std::string(Buffer.begin(), Buffer.end()) == Expected) << Size;
+        EXPECT_TRUE(Source.End());
+    }
+}
+
+TEST_F(FileDataSource, OversizedReadTest){
+    // asking for far more than the file holds only allocates for what is there
+    for(auto Size : FileSizes){
+        std::string Expected = Contents(Size);
+        CFileDataSource Source(TestFile(Expected));
+        std::vector<char> Buffer;
+        EXPECT_EQ(Source.Read(Buffer, std::size_t(1) << 30), Size != 0);
+        EXPECT_TRUE(std::string(Buffer.begin(), Buffer.end()) == Expected) << Size;
+        EXPECT_LE(Buffer.capacity(), 2 * (Size + 65536)) << Size;
+        EXPECT_TRUE(Source.End());
+    }
+}
+
+TEST_F(FileDataSource, BinaryTest){
+    // 0xff is not the end of the file, and nothing is translated
+    std::string Expected("\xff\r\n\x1a\0\n\r\xff\xfe\x80", 10);
+    CFileDataSource Source(TestFile(Expected));
+    std::string Actual;
+    char TempCh;
+    while(Source.Get(TempCh)){
+        Actual.push_back(TempCh);
+    }
+    EXPECT_EQ(Actual.size(), Expected.size());
+    EXPECT_TRUE(Actual == Expected);
+    EXPECT_EQ((unsigned char)Actual[0], 0xFF);
+    EXPECT_TRUE(Source.End());
+}
+
+TEST_F(FileDataSource, MissingFileTest){
+    CFileDataSource Source(BaseDirectory + "missing.bin");
+    std::vector<char> Buffer;
+    char TempCh;
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_FALSE(Source.Peek(TempCh));
+    EXPECT_FALSE(Source.Read(Buffer, 10));
+}
+
+TEST_F(FileDataSource, BorrowTest){
+    // borrows of every size mixed in with the other reads, across the block boundaries
+    const std::size_t BorrowSizes[] = {1, 65536, 13, 70000, 65535, 2, 1000000};
+    for(auto Size : FileSizes){
+        std::string Expected = Contents(Size);
+        CFileDataSource Source(TestFile(Expected));
+        std::vector<char> Buffer;
+        std::string_view Chunk;
+        std::string Actual;
+        std::size_t Step = 0;
+        while(!Source.End()){
+            std::size_t Max = BorrowSizes[Step % (sizeof(BorrowSizes) / sizeof(BorrowSizes[0]))];
+            ASSERT_TRUE(Source.Borrow(Chunk, Max));
+            ASSERT_FALSE(Chunk.empty());
+            ASSERT_LE(Chunk.size(), Max);
+            ASSERT_TRUE(Chunk == std::string_view(Expected).substr(Actual.size(), Chunk.size())) << Size << " at " << Actual.size();
+            Actual.append(Chunk);
+            char TempCh;
+            switch(Step++ % 3){
+                case 0:     if(Source.Get(TempCh)){
+                                Actual.push_back(TempCh);
+                            }
+                            break;
+                case 1:     if(Source.Read(Buffer, 40000)){
+                                Actual.append(Buffer.begin(), Buffer.end());
+                            }
+                            break;
+                default:    break;
+            }
+        }
+        EXPECT_EQ(Actual.size(), Size);
+        EXPECT_TRUE(Actual == Expected) << Size;
+        EXPECT_FALSE(Source.Borrow(Chunk, 10));
+        EXPECT_TRUE(Chunk.empty());
+    }
+}
+
+TEST_F(FileDataSource, BorrowRefillTest){
+    // a borrow that takes the rest of the block refills it, the borrowed bytes have to survive that
+    std::string Expected = Contents(200003);
+    CFileDataSource Source(TestFile(Expected));
+    std::string_view Chunk, Next;
+    char TempCh;
+
+    EXPECT_TRUE(Source.Borrow(Chunk, 100));
+    EXPECT_TRUE(Chunk == std::string_view(Expected).substr(0, 100));
+    EXPECT_TRUE(Source.Borrow(Chunk, 1000000));
+    EXPECT_EQ(Chunk.size(), 65536 - 100);
+    EXPECT_TRUE(Chunk == std::string_view(Expected).substr(100, 65536 - 100));
+    // the next block is already in, and peeking at it doesnt touch the lent one
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh, Expected[65536]);
+    EXPECT_TRUE(Chunk == std::string_view(Expected).substr(100, 65536 - 100));
+
+    EXPECT_TRUE(Source.Borrow(Next, 65536));
+    EXPECT_EQ(Next.size(), 65536);
+    EXPECT_TRUE(Next == std::string_view(Expected).substr(65536, 65536));
+    EXPECT_TRUE(Source.Borrow(Chunk, 65536));
+    EXPECT_TRUE(Chunk == std::string_view(Expected).substr(131072, 65536));
+    EXPECT_TRUE(Source.Borrow(Chunk, 65536));
+    EXPECT_TRUE(Chunk == std::string_view(Expected).substr(196608));
+    EXPECT_TRUE(Source.End());
+}
+
+
+TEST(FileDataSourceSink, MapThresholdTest){
+    std::string SmallName = "small.txt", LargeName = "large.txt";
+    std::string Small(100, 's'), Large(CFileDataFactory::DefaultMapThreshold, 'l');
+    {
+        CFileDataFactory DataFactory(BaseDirectory);
+        EXPECT_TRUE(DataFactory.CreateSink(SmallName)->Write(std::vector<char>(Small.begin(), Small.end())));
+        EXPECT_TRUE(DataFactory.CreateSink(LargeName)->Write(std::vector<char>(Large.begin(), Large.end())));
+    }
+    // which kind of source comes back, and that it reads the whole file either way
+    auto Check = [](std::shared_ptr< CDataSource > source, bool mapped, const std::string &expected){
+        ASSERT_TRUE(source);
+        EXPECT_EQ(std::dynamic_pointer_cast< CMMapDataSource >(source) != nullptr, mapped);
+        EXPECT_EQ(std::dynamic_pointer_cast< CFileDataSource >(source) != nullptr, !mapped);
+        std::vector<char> Buffer;
+        EXPECT_TRUE(source->Read(Buffer, expected.size() + 1));
+        EXPECT_TRUE(std::string(Buffer.begin(), Buffer.end()) == expected);
+        EXPECT_TRUE(source->End());
+    };
+
+    CFileDataFactory AlwaysFactory(BaseDirectory, CFileDataFactory::AlwaysMap);
+    Check(AlwaysFactory.CreateSource(SmallName), true, Small);
+    Check(AlwaysFactory.CreateSource(LargeName), true, Large);
+
+    CFileDataFactory NeverFactory(BaseDirectory, CFileDataFactory::NeverMap);
+    Check(NeverFactory.CreateSource(SmallName), false, Small);
+    Check(NeverFactory.CreateSource(LargeName), false, Large);
+
+    // the default maps from the threshold up
+    CFileDataFactory DefaultFactory(BaseDirectory);
+    Check(DefaultFactory.CreateSource(SmallName), false, Small);
+    Check(DefaultFactory.CreateSource(LargeName), true, Large);
+
+    // a file that isnt there is still a (empty) stream source
+    auto Missing = AlwaysFactory.CreateSource("missing.txt");
+    ASSERT_TRUE(Missing);
+    EXPECT_NE(std::dynamic_pointer_cast< CFileDataSource >(Missing), nullptr);
+    EXPECT_TRUE(Missing->End());
+}
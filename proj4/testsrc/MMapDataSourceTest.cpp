@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "MMapDataSource.h"
+#include "FileDataFactory.h"
+
+// Assume being run from Makefile so testtmp is subdirectory
+const std::string BaseDirectory = "./testtmp/";
+
+TEST(MMapDataSource, GetPeekTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    EXPECT_TRUE(DataFactory.CreateSink("mmapgetpeek.txt")->Write({'H', 'i', '\xff'}));
+    CMMapDataSource Source(BaseDirectory + "mmapgetpeek.txt");
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.Valid());
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'i');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'\xff');
+    EXPECT_TRUE(Source.End());
+    TempCh = 'x';
+    EXPECT_FALSE(Source.Peek(TempCh));
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+}
+
+TEST(MMapDataSource, ReadTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    std::string Contents = "Hello World";
+    EXPECT_TRUE(DataFactory.CreateSink("mmapread.txt")->Write(std::vector<char>(Contents.begin(), Contents.end())));
+    CMMapDataSource Source(BaseDirectory + "mmapread.txt");
+    std::vector<char> Buffer;
+
+    EXPECT_TRUE(Source.Read(Buffer, 5));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()), "Hello");
+    EXPECT_EQ(Source.Remaining(), " World");
+    EXPECT_EQ(Source.Contents(), "Hello World");
+    EXPECT_TRUE(Source.Read(Buffer, 100));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()), " World");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Read(Buffer, 1));
+    EXPECT_TRUE(Buffer.empty());
+}
+
+TEST(MMapDataSource, BorrowTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    DataFactory.CreateSink("mmapborrow.txt")->Write({'H','e','l','l','o',' ','W','o','r','l','d'});
+    CMMapDataSource Source(BaseDirectory + "mmapborrow.txt");
+    std::string_view Chunk;
+
+    EXPECT_TRUE(Source.Borrow(Chunk, 5));
+    EXPECT_EQ(Chunk, "Hello");
+    EXPECT_EQ(Chunk.data(), Source.Contents().data());
+    EXPECT_TRUE(Source.Borrow(Chunk, 100));
+    EXPECT_EQ(Chunk, " World");
+    EXPECT_FALSE(Source.Borrow(Chunk, 100));
+    EXPECT_TRUE(Chunk.empty());
+}
+
+TEST(MMapDataSource, EmptyAndMissingTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    {
+        auto Sink = DataFactory.CreateSink("mmapempty.txt");
+    }
+    CMMapDataSource Empty(BaseDirectory + "mmapempty.txt");
+    CMMapDataSource Missing(BaseDirectory + "missing.txt");
+    std::vector<char> Buffer;
+    char TempCh;
+
+    EXPECT_TRUE(Empty.Valid());
+    EXPECT_TRUE(Empty.End());
+    EXPECT_FALSE(Empty.Get(TempCh));
+    EXPECT_FALSE(Missing.Valid());
+    EXPECT_TRUE(Missing.End());
+    EXPECT_FALSE(Missing.Read(Buffer, 1));
+    EXPECT_TRUE(Missing.Contents().empty());
+}
@@ -4,4 +4,224 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <fstream>
+#include <iterator>
 
+#include "StringDataSource.h"
+
+TEST(OpenStreetMapTest, LookupByIDTest){
+    // enough nodes that the id index has to grow a few times, ids out of order and one repeated
+    std::string OSM = "<?xml version='1.0' encoding='UTF-8'?><osm version=\"0.6\">";
+    for(int Index = 0; Index < 100; Index++){
+        OSM += "<node id=\"" + std::to_string(1000 - Index * 7) + "\" lat=\"38.5\" lon=\"" + std::to_string(-121.0 - Index) + "\"/>";
+    }
+    OSM += "<node id=\"1000\" lat=\"1.0\" lon=\"1.0\"/>";
+    OSM += "<way id=\"5\"><nd ref=\"1000\"/><nd ref=\"993\"/></way><way id=\"3\"><nd ref=\"993\"/></way>";
+    OSM += "</osm>";
+    COpenStreetMap StreetMap(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(OSM)));
+
+    ASSERT_EQ(StreetMap.NodeCount(), 101);
+    for(int Index = 0; Index < 100; Index++){
+        auto Node = StreetMap.NodeByID(1000 - Index * 7);
+        ASSERT_TRUE(Node);
+        EXPECT_EQ(Node->ID(), 1000 - Index * 7);
+        EXPECT_EQ(Node->Location().second, -121.0 - Index);
+    }
+    // the first node with a repeated id is the one found
+    EXPECT_EQ(StreetMap.NodeByID(1000)->Location().first, 38.5);
+    EXPECT_EQ(StreetMap.NodeByID(999), nullptr);
+    EXPECT_EQ(StreetMap.WayByID(3)->NodeCount(), 1);
+    EXPECT_EQ(StreetMap.WayByID(5)->NodeCount(), 2);
+    EXPECT_EQ(StreetMap.WayByID(4), nullptr);
+}
+
+TEST(OpenStreetMapTest, NodeAttributeTest){
+    std::string OSM = "<?xml version='1.0' encoding='UTF-8'?><osm version=\"0.6\">"
+                      "<node id=\"1\" lat=\"38.5\" lon=\"-121.7\"><tag k=\"highway\" v=\"stop\"/><tag k=\"name\" v=\"A\"/><tag k=\"name\" v=\"B\"/></node>"
+                      "<node id=\"2\" lat=\"38.6\" lon=\"-121.8\"/>"
+                      "<node id=\"3\" lat=\"38.7\" lon=\"-121.9\"><tag k=\"amenity\" v=\"bench\"/></node>"
+                      "</osm>";
+    std::shared_ptr<CStreetMap::SNode> Node;
+    {
+        COpenStreetMap StreetMap(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(OSM)));
+        ASSERT_EQ(StreetMap.NodeCount(), 3);
+        auto First = StreetMap.NodeByIndex(0);
+        // a repeated key keeps the last value
+        EXPECT_EQ(First->AttributeCount(), 2);
+        EXPECT_EQ(First->GetAttributeKey(0), "highway");
+        EXPECT_EQ(First->GetAttribute("name"), "B");
+        EXPECT_FALSE(First->HasAttribute("amenity"));
+        EXPECT_EQ(StreetMap.NodeByIndex(1)->AttributeCount(), 0);
+        EXPECT_EQ(StreetMap.NodeByIndex(1)->GetAttributeKey(0), "");
+        EXPECT_EQ(StreetMap.NodeByIndex(3), nullptr);
+        Node = StreetMap.NodeByID(3);
+    }
+    // handles keep the node store alive
+    ASSERT_TRUE(Node);
+    EXPECT_EQ(Node->Location().first, 38.7);
+    EXPECT_EQ(Node->GetAttribute("amenity"), "bench");
+}
+
+TEST(OpenStreetMapTest, WayAttributeTest){
+    std::string OSM = "<?xml version='1.0' encoding='UTF-8'?><osm version=\"0.6\">"
+                      "<node id=\"1\" lat=\"38.5\" lon=\"-121.7\"><tag k=\"name\" v=\"yes\"/></node>"
+                      "<way id=\"10\"><nd ref=\"1\"/><tag k=\"oneway\" v=\"yes\"/><tag k=\"surface\" v=\"asphalt\"/><tag k=\"oneway\" v=\"no\"/></way>"
+                      "<way id=\"11\"><nd ref=\"1\"/><tag k=\"maxspeed\" v=\"25 mph\"/><tag k=\"name\" v=\"yes\"/></way>"
+                      "</osm>";
+    COpenStreetMap StreetMap(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(OSM)));
+    auto First = StreetMap.WayByID(10);
+    ASSERT_TRUE(First);
+    // keys come back in the order they were read, a repeated key keeps the last value
+    EXPECT_EQ(First->AttributeCount(), 2);
+    EXPECT_EQ(First->GetAttributeKey(0), "oneway");
+    EXPECT_EQ(First->GetAttributeKey(1), "surface");
+    EXPECT_EQ(First->GetAttributeKey(2), "");
+    EXPECT_EQ(First->GetAttribute("oneway"), "no");
+    EXPECT_FALSE(First->HasAttribute("maxspeed"));
+    EXPECT_FALSE(First->HasAttribute("asphalt"));
+    EXPECT_FALSE(First->HasAttribute("lanes"));
+    EXPECT_EQ(First->GetAttribute("lanes"), "");
+    // strings are shared between nodes and ways but stay separate per entity
+    auto Second = StreetMap.WayByID(11);
+    EXPECT_EQ(Second->GetAttribute("maxspeed"), "25 mph");
+    EXPECT_EQ(Second->GetAttribute("name"), "yes");
+    EXPECT_EQ(StreetMap.NodeByID(1)->GetAttribute("name"), "yes");
+    EXPECT_FALSE(StreetMap.NodeByID(1)->HasAttribute("oneway"));
+}
+
+TEST(OpenStreetMapTest, ParallelLoadTest){
+    // big enough to be cut into pieces, with tags first used in later pieces and ways spread through the file
+    std::string OSM = "<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\">\n";
+    for(int Index = 0; Index < 20000; Index++){
+        OSM += "  <node id=\"" + std::to_string(Index) + "\" lat=\"38.5\" lon=\"" + std::to_string(-121.0 - Index / 1000.0) + "\">"
+               "<tag k=\"kind" + std::to_string(Index / 4000) + "\" v=\"" + std::to_string(Index % 7) + "\"/></node>\n";
+        if(Index % 100 == 99){
+            OSM += "  <way id=\"" + std::to_string(Index) + "\"><nd ref=\"" + std::to_string(Index) + "\"/><tag k=\"highway\" v=\"road" + std::to_string(Index / 5000) + "\"/></way>\n";
+        }
+    }
+    OSM += "</osm>\n";
+    ASSERT_GT(OSM.size(), 1u << 20);
+    COpenStreetMap Serial(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(OSM)));
+    // the comment stops it from being cut at all, the result has to be the same either way
+    for(auto Document : {OSM, OSM + "<!-- <node id=\"1\"/> -->"}){
+        COpenStreetMap Parallel(std::make_shared<CStringDataSource>(Document), 4);
+        ASSERT_EQ(Parallel.NodeCount(), Serial.NodeCount());
+        ASSERT_EQ(Parallel.WayCount(), Serial.WayCount());
+        for(std::size_t Index = 0; Index < Serial.NodeCount(); Index++){
+            auto Expected = Serial.NodeByIndex(Index), Node = Parallel.NodeByIndex(Index);
+            ASSERT_EQ(Node->ID(), Expected->ID());
+            EXPECT_EQ(Node->Location(), Expected->Location());
+            ASSERT_EQ(Node->AttributeCount(), 1);
+            EXPECT_EQ(Node->GetAttributeKey(0), Expected->GetAttributeKey(0));
+            EXPECT_EQ(Node->GetAttribute(Node->GetAttributeKey(0)), Expected->GetAttribute(Node->GetAttributeKey(0)));
+            EXPECT_EQ(Parallel.NodeByID(Node->ID())->ID(), Node->ID());
+        }
+        for(std::size_t Index = 0; Index < Serial.WayCount(); Index++){
+            auto Expected = Serial.WayByIndex(Index), Way = Parallel.WayByIndex(Index);
+            ASSERT_EQ(Way->ID(), Expected->ID());
+            EXPECT_EQ(Way->GetNodeID(0), Expected->GetNodeID(0));
+            EXPECT_EQ(Way->GetAttribute("highway"), Expected->GetAttribute("highway"));
+            EXPECT_EQ(Parallel.WayByID(Way->ID()), Way);
+        }
+    }
+}
+
+TEST(OpenStreetMapTest, PBFLoadTest){
+    // data/city.osm.pbf holds the same nodes and ways as data/city.osm, in dense and plain node blocks, zlib and raw
+    // (written by osm2pbf, make citypbf)
+    std::ifstream PBFFile("data/city.osm.pbf", std::ios::binary), XMLFile("data/city.osm");
+    ASSERT_TRUE(PBFFile.good() && XMLFile.good());
+    std::string PBF((std::istreambuf_iterator<char>(PBFFile)), std::istreambuf_iterator<char>());
+    std::string XML((std::istreambuf_iterator<char>(XMLFile)), std::istreambuf_iterator<char>());
+    COpenStreetMap Expected(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(XML)));
+    for(std::size_t Threads : {1, 2, 4}){
+        COpenStreetMap StreetMap(std::make_shared<CStringDataSource>(PBF), Threads);
+        ASSERT_EQ(StreetMap.NodeCount(), Expected.NodeCount());
+        ASSERT_EQ(StreetMap.WayCount(), Expected.WayCount());
+        for(std::size_t Index = 0; Index < Expected.NodeCount(); Index++){
+            auto ExpectedNode = Expected.NodeByIndex(Index), Node = StreetMap.NodeByIndex(Index);
+            ASSERT_EQ(Node->ID(), ExpectedNode->ID());
+            EXPECT_EQ(Node->Location(), ExpectedNode->Location());
+            ASSERT_EQ(Node->AttributeCount(), ExpectedNode->AttributeCount());
+            for(std::size_t Attribute = 0; Attribute < Node->AttributeCount(); Attribute++){
+                auto Key = ExpectedNode->GetAttributeKey(Attribute);
+                EXPECT_EQ(Node->GetAttributeKey(Attribute), Key);
+                EXPECT_EQ(Node->GetAttribute(Key), ExpectedNode->GetAttribute(Key));
+            }
+        }
+        for(std::size_t Index = 0; Index < Expected.WayCount(); Index++){
+            auto ExpectedWay = Expected.WayByIndex(Index), Way = StreetMap.WayByIndex(Index);
+            ASSERT_EQ(Way->ID(), ExpectedWay->ID());
+            ASSERT_EQ(Way->NodeCount(), ExpectedWay->NodeCount());
+            for(std::size_t Node = 0; Node < Way->NodeCount(); Node++){
+                EXPECT_EQ(Way->GetNodeID(Node), ExpectedWay->GetNodeID(Node));
+            }
+            ASSERT_EQ(Way->AttributeCount(), ExpectedWay->AttributeCount());
+            for(std::size_t Attribute = 0; Attribute < Way->AttributeCount(); Attribute++){
+                auto Key = ExpectedWay->GetAttributeKey(Attribute);
+                EXPECT_EQ(Way->GetAttributeKey(Attribute), Key);
+                EXPECT_EQ(Way->GetAttribute(Key), ExpectedWay->GetAttribute(Key));
+            }
+            EXPECT_EQ(StreetMap.WayByID(Way->ID()), Way);
+        }
+    }
+    // a file cut off in the middle keeps the blocks before the cut, one that isnt PBF at all is read as XML
+    COpenStreetMap Truncated(std::make_shared<CStringDataSource>(PBF.substr(0, PBF.size() - 100)), 2);
+    EXPECT_GT(Truncated.NodeCount(), 0);
+    EXPECT_EQ(Truncated.NodeCount(), Expected.NodeCount());
+    EXPECT_LT(Truncated.WayCount(), Expected.WayCount());
+    COpenStreetMap Damaged(std::make_shared<CStringDataSource>(PBF.substr(0, 40)), 2);
+    EXPECT_EQ(Damaged.NodeCount(), 0);
+    EXPECT_EQ(Damaged.WayCount(), 0);
+}
+
+TEST(OpenStreetMapTest, FilterTest){
+    auto OSM = "<?xml version='1.0' encoding='UTF-8'?><osm version=\"0.6\">"
+               "<node id=\"1\" lat=\"1.0\" lon=\"-1.0\"><tag k=\"highway\" v=\"traffic_signals\"/></node>"
+               "<node id=\"2\" lat=\"2.0\" lon=\"-2.0\"/>"
+               "<node id=\"3\" lat=\"3.0\" lon=\"-3.0\"><tag k=\"amenity\" v=\"cafe\"/></node>"
+               "<node id=\"4\" lat=\"4.0\" lon=\"-4.0\"/>"
+               "<node id=\"5\" lat=\"5.0\" lon=\"-5.0\"/>"
+               "<node id=\"6\" lat=\"6.0\" lon=\"-6.0\"/>"
+               "<way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/><tag k=\"highway\" v=\"residential\"/><tag k=\"name\" v=\"A St\"/><tag k=\"surface\" v=\"asphalt\"/></way>"
+               "<way id=\"11\"><nd ref=\"3\"/><nd ref=\"4\"/><nd ref=\"3\"/><tag k=\"building\" v=\"yes\"/></way>"
+               "<way id=\"12\"><nd ref=\"2\"/><nd ref=\"5\"/><tag k=\"highway\" v=\"proposed\"/></way>"
+               "<way id=\"13\"><nd ref=\"2\"/><nd ref=\"1\"/><nd ref=\"99\"/><tag k=\"highway\" v=\"service\"/><tag k=\"oneway\" v=\"yes\"/></way>"
+               "</osm>";
+    auto Filter = COpenStreetMap::SFilter::Routing();
+    Filter.Nodes = {6, 100};
+    COpenStreetMap StreetMap(std::make_shared<CStringDataSource>(OSM), Filter, 1);
+    ASSERT_EQ(StreetMap.NodeCount(), 3);
+    EXPECT_EQ(StreetMap.NodeByIndex(0)->ID(), 1);
+    EXPECT_EQ(StreetMap.NodeByIndex(1)->ID(), 2);
+    EXPECT_EQ(StreetMap.NodeByIndex(2)->ID(), 6);
+    EXPECT_EQ(StreetMap.NodeByID(1)->AttributeCount(), 0);
+    EXPECT_EQ(StreetMap.NodeByID(3), nullptr);
+    EXPECT_EQ(StreetMap.NodeByID(5), nullptr);
+    ASSERT_EQ(StreetMap.WayCount(), 2);
+    auto Way = StreetMap.WayByIndex(0);
+    EXPECT_EQ(Way->ID(), 10);
+    EXPECT_EQ(Way->NodeCount(), 2);
+    ASSERT_EQ(Way->AttributeCount(), 2);
+    EXPECT_EQ(Way->GetAttributeKey(0), "highway");
+    EXPECT_EQ(Way->GetAttribute("name"), "A St");
+    EXPECT_FALSE(Way->HasAttribute("surface"));
+    EXPECT_EQ(StreetMap.WayByID(13)->GetAttribute("oneway"), "yes");
+    EXPECT_EQ(StreetMap.WayByID(13)->GetNodeID(2), 99);
+    EXPECT_EQ(StreetMap.WayByID(11), nullptr);
+
+    auto Counts = StreetMap.FilterCounts();
+    EXPECT_EQ(Counts.NodesBefore, 6);
+    EXPECT_EQ(Counts.NodesAfter, 3);
+    EXPECT_EQ(Counts.WaysBefore, 4);
+    EXPECT_EQ(Counts.WaysAfter, 2);
+    EXPECT_EQ(Counts.TagsBefore, 9);
+    EXPECT_EQ(Counts.TagsAfter, 4);
+    EXPECT_LT(Counts.StringsAfter, Counts.StringsBefore);
+
+    COpenStreetMap Unfiltered(std::make_shared<CStringDataSource>(OSM), 1);
+    Counts = Unfiltered.FilterCounts();
+    EXPECT_EQ(Counts.NodesBefore, 6);
+    EXPECT_EQ(Counts.NodesAfter, 6);
+    EXPECT_EQ(Counts.TagsAfter, 9);
+}
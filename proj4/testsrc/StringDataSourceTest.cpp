@@ -81,3 +81,20 @@ TEST(StringDataSource, ReadTest){
     EXPECT_FALSE(Source2.Peek(TempCh));
     EXPECT_EQ(TempCh,'x');
 }
+
+TEST(StringDataSource, BorrowTest){
+    CStringDataSource EmptySource("");
+    CStringDataSource Source("Hello World");
+    std::string_view Chunk;
+    char TempCh;
+
+    EXPECT_FALSE(EmptySource.Borrow(Chunk, 4));
+    EXPECT_TRUE(Chunk.empty());
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_TRUE(Source.Borrow(Chunk, 4));
+    EXPECT_EQ(Chunk, "ello");
+    EXPECT_TRUE(Source.Borrow(Chunk, 100));
+    EXPECT_EQ(Chunk, " World");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Borrow(Chunk, 100));
+}
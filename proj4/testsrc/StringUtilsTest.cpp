@@ -75,4 +75,18 @@ TEST(StringUtilsTest, ExpandTabs){
 }
 TEST(StringUtilsTest, EditDistance){
   
-}
\ No newline at end of file
+}
+TEST(StringUtilsTest, ParseUnsigned){
+    // should give the same answer as stoull for everything stoull accepts
+    for(std::string Str : {"0", "42", "  7", "\t\n123", "+9", "-1", "18446744073709551615", "12abc", "007"}){
+        EXPECT_EQ(StringUtils::ParseUnsigned(Str), std::stoull(Str)) << Str;
+    }
+    // and fail the same way for what it doesnt
+    for(std::string Str : {"", "   ", "abc", "-", "+ 1", "x12"}){
+        EXPECT_THROW(std::stoull(Str), std::invalid_argument) << Str;
+        EXPECT_THROW(StringUtils::ParseUnsigned(Str), std::invalid_argument) << Str;
+    }
+    EXPECT_THROW(std::stoull("18446744073709551616"), std::out_of_range);
+    EXPECT_THROW(StringUtils::ParseUnsigned("18446744073709551616"), std::out_of_range);
+    EXPECT_THROW(StringUtils::ParseUnsigned(" 99999999999999999999999"), std::out_of_range);
+}
@@ -22,3 +22,83 @@
     EXPECT_EQ(dataSink->String(), "<tag>data</tag>");
 }
 
+
+ TEST(XMLTest, LargeDocument) {
+    // big enough that elements and attribute values get split between the chunks the reader feeds expat
+    std::string document = "<osm>";
+    for (int i = 0; i < 5000; i++) {
+        document += "<node id=\"" + std::to_string(i) + "\" name=\"" + std::string(i % 50, 'x') + "\"/>";
+    }
+    document += "</osm>";
+    CXMLReader reader(std::make_shared<CStringDataSource>(document));
+
+    SXMLEntity entity;
+    ASSERT_TRUE(reader.ReadEntity(entity, true));
+    EXPECT_EQ(entity.DNameData, "osm");
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_TRUE(reader.ReadEntity(entity, true));
+        EXPECT_EQ(entity.DType, SXMLEntity::EType::StartElement);
+        EXPECT_EQ(entity.AttributeValue("id"), std::to_string(i));
+        EXPECT_EQ(entity.AttributeValue("name"), std::string(i % 50, 'x'));
+        ASSERT_TRUE(reader.ReadEntity(entity, true));
+        EXPECT_EQ(entity.DType, SXMLEntity::EType::EndElement);
+    }
+    ASSERT_TRUE(reader.ReadEntity(entity, true));
+    EXPECT_EQ(entity.DNameData, "osm");
+    EXPECT_FALSE(reader.ReadEntity(entity, true));
+    EXPECT_TRUE(reader.End());
+}
+
+ // writes what it is called with as text so the tests can compare the whole sequence
+ class CRecordingHandler : public CXMLReader::CHandler {
+    public:
+        std::string Calls;
+
+        void StartElement(const char *name, const char **attributes) override {
+            Calls += std::string("<") + name;
+            for (auto attribute = attributes; *attribute; attribute += 2) {
+                Calls += std::string(" ") + attribute[0] + "=" + attribute[1];
+            }
+            Calls += ">";
+        }
+        void EndElement(const char *name) override {
+            Calls += std::string("</") + name + ">";
+        }
+        void CharacterData(const char *data, std::size_t length) override {
+            Calls += std::string(data, length);
+        }
+ };
+
+ TEST(XMLTest, ParseHandler) {
+    const std::string document = "<osm version=\"0.6\"><node id=\"1\" lat=\"2\"/>text<way id=\"3\"><nd ref=\"1\"/></way></osm>";
+    CXMLReader reader(std::make_shared<CStringDataSource>(document));
+    CRecordingHandler handler;
+    EXPECT_TRUE(reader.Parse(handler));
+    EXPECT_EQ(handler.Calls, "<osm version=0.6><node id=1 lat=2></node>text<way id=3><nd ref=1></nd></way></osm>");
+    EXPECT_TRUE(reader.End());
+
+    // what ReadEntity already took out stays taken, what it parsed but didnt hand out yet goes to the handler
+    CXMLReader mixed(std::make_shared<CStringDataSource>(document));
+    SXMLEntity entity;
+    ASSERT_TRUE(mixed.ReadEntity(entity));
+    EXPECT_EQ(entity.DNameData, "osm");
+    CRecordingHandler rest;
+    EXPECT_TRUE(mixed.Parse(rest));
+    EXPECT_EQ(rest.Calls, "<node id=1 lat=2></node>text<way id=3><nd ref=1></nd></way></osm>");
+
+    CXMLReader bad(std::make_shared<CStringDataSource>("<osm><node></osm>"));
+    CRecordingHandler partial;
+    EXPECT_FALSE(bad.Parse(partial));
+ }
+
+ TEST(XMLTest, ParseHandlerThrows) {
+    class CThrowingHandler : public CXMLReader::CHandler {
+        public:
+            void EndElement(const char *name) override {
+                throw std::runtime_error(name);
+            }
+    };
+    CXMLReader reader(std::make_shared<CStringDataSource>("<osm><node/></osm>"));
+    CThrowingHandler handler;
+    EXPECT_THROW(reader.Parse(handler), std::runtime_error);
+ }